@@ -1,72 +1,410 @@
 #include "haier.h"
 
+#include <cmath>
+#include <set>
+
 #include "esphome.h"
 
-#include "control.h"
 #include "constants.h"
-#include "initialization.h"
+#include "control.h"
+#include "profiles.h"
 
 using esphome::esp_log_printf_;
 using esphome::climate::ClimateCall;
 using esphome::climate::ClimateMode;
 using esphome::climate::ClimateFanMode;
+using esphome::climate::ClimatePreset;
 using esphome::climate::ClimateSwingMode;
 using esphome::climate::ClimateTraits;
+using esphome::binary_sensor::BinarySensor;
+using esphome::sensor::Sensor;
+
+void HaierFeatureSwitch::write_state(bool state) {
+  ControlRequest request;
+  request.*feature_ = state;
+  haier_.Request(request);
+}
+
+Haier::Haier(HardwareSerial &uart) : uart_(uart), engine_(uart) {}
+
+#ifdef ARDUINO_ARCH_ESP32
+void Haier::set_uart_pins(int8_t rx_pin, int8_t tx_pin) {
+  rx_pin_ = rx_pin;
+  tx_pin_ = tx_pin;
+}
+#endif
+
+void Haier::set_fast_poll_interval(uint32_t interval) {
+  engine_.poll_scheduler().set_fast_interval(interval);
+}
+
+void Haier::set_fast_poll_duration(uint32_t duration) {
+  engine_.poll_scheduler().set_fast_duration(duration);
+}
 
-Haier::Haier() : PollingComponent(kPollingIntervalInMilisec) {}
+void Haier::set_poll_interval(uint32_t interval) {
+  engine_.poll_scheduler().set_interval(interval);
+}
+
+void Haier::set_slow_poll_interval(uint32_t interval) {
+  engine_.poll_scheduler().set_slow_interval(interval);
+}
+
+void Haier::set_stable_duration(uint32_t duration) {
+  engine_.poll_scheduler().set_stable_duration(duration);
+}
+
+void Haier::set_current_temperature_deadband(float deadband) {
+  current_temperature_deadband_ = deadband;
+}
+
+void Haier::set_poll_rtt_sensor(Sensor *sensor) { poll_rtt_sensor_ = sensor; }
+
+void Haier::set_control_latency_sensor(Sensor *sensor) {
+  control_latency_sensor_ = sensor;
+}
+
+void Haier::set_checksum_failures_sensor(Sensor *sensor) {
+  checksum_failures_sensor_ = sensor;
+}
+
+void Haier::set_temperature_rejects_sensor(Sensor *sensor) {
+  temperature_rejects_sensor_ = sensor;
+}
+
+void Haier::set_resyncs_sensor(Sensor *sensor) { resyncs_sensor_ = sensor; }
+
+void Haier::set_dropped_bytes_sensor(Sensor *sensor) {
+  dropped_bytes_sensor_ = sensor;
+}
+
+void Haier::set_loop_time_sensor(Sensor *sensor) { loop_time_sensor_ = sensor; }
+
+void Haier::set_pending_sensor(BinarySensor *sensor) {
+  pending_sensor_ = sensor;
+}
+
+void Haier::set_room_temperature_sensor(Sensor *sensor) {
+  room_temperature_sensor_ = sensor;
+}
+
+void Haier::set_connectivity_sensor(BinarySensor *sensor) {
+  connectivity_sensor_ = sensor;
+}
+
+void Haier::set_lock_sensor(BinarySensor *sensor) { lock_sensor_ = sensor; }
+
+void Haier::set_fresh_sensor(BinarySensor *sensor) { fresh_sensor_ = sensor; }
 
 void Haier::setup() {
-  Serial.begin(9600);
-  Initialization().Initialize();
+#ifdef ARDUINO_ARCH_ESP32
+  uart_.begin(9600, SERIAL_8N1, rx_pin_, tx_pin_);
+#else
+  uart_.begin(9600);
+#endif
+#ifdef HAIER_RX_CALLBACK
+  uart_.onReceive([this]() { engine_.rx_buffer().Fill(); });
+#endif
+  // Published and controllable right away, until the first status corrects it
+  preference_ = esphome::global_preferences->make_preference<PersistedStatus>(
+      get_object_id_hash() ^ kPersistedStatusVersion, true);
+  PersistedStatus saved;
+  if (preference_.load(&saved)) {
+    saver_.set_saved(saved);
+    if (engine_.Restore(saved))
+      ESP_LOGI("EspHaier State", "Last known state restored");
+  }
+  engine_.Start();
+  if (room_temperature_sensor_ != nullptr) {
+    target_preference_ = esphome::global_preferences->make_preference<float>(
+        get_object_id_hash() ^ kThermostatTargetPreference, true);
+    float target;
+    if (target_preference_.load(&target) && !std::isnan(target))
+      Climate::target_temperature = target;
+    room_temperature_sensor_->add_on_state_callback(
+        [this](float room_temperature) {
+          OnRoomTemperature(room_temperature);
+        });
+  }
+  if (pending_sensor_ != nullptr)
+    pending_sensor_->publish_state(false);
+  register_service(&Haier::DumpHistory,
+                   "dump_" + get_object_id() + "_history");
+#ifdef ARDUINO_ARCH_ESP32
+  xTaskCreatePinnedToCore(&Haier::ProtocolTask, "haier", kProtocolTaskStackSize,
+                          this, kProtocolTaskPriority, nullptr,
+                          kProtocolTaskCore);
+#endif
 }
 
+#ifdef ARDUINO_ARCH_ESP32
+void Haier::ProtocolTask(void *haier) {
+  ProtocolEngine &engine = static_cast<Haier *>(haier)->engine_;
+  static_cast<Haier *>(haier)->task_log_.Attach();
+  for (;;) {
+    engine.Loop();
+    vTaskDelay(1);
+  }
+}
+#endif
+
 void Haier::loop() {
-  if (!status_.OnPendingData())
-    return;
+#ifdef ARDUINO_ARCH_ESP32
+  task_log_.Flush();
+#else
+  engine_.Loop();
+#endif
+
+  if (engine_.PopStats(stats_))
+    PublishStats();
+
+  const bool connected = engine_.IsConnected();
+  if (connectivity_sensor_ != nullptr &&
+      (!connected_ || *connected_ != connected))
+    connectivity_sensor_->publish_state(connected);
+  connected_ = connected;
+
+  PersistedStatus persisted;
+  while (engine_.PopPersisted(persisted))
+    saver_.Update(persisted);
+  saver_.Loop(millis(), [this](const PersistedStatus &status) {
+    return preference_.save(&status);
+  });
 
-  status_.LogStatus();
+  ControlResult result;
+  while (engine_.PopResult(result))
+    state_.OnResult(result);
 
-  Climate::mode = status_.GetMode();
-  Climate::fan_mode = status_.GetFanMode();
-  Climate::swing_mode = status_.GetSwingMode();
-  Climate::current_temperature = status_.GetCurrentTemperature();
-  Climate::target_temperature = status_.GetTargetTemperature();
-  Climate::publish_state();
+  StatusSnapshot snapshot;
+  bool changed = false;
+  while (engine_.PopStatus(snapshot)) {
+    first_status_received_ = true;
+    state_.OnStatus(snapshot);
+    changed |= UpdateState(snapshot);
+  }
+  state_.Loop(millis());
+  if (first_status_received_)
+    changed |= ApplyState();
+  if (changed)
+    Climate::publish_state();
+
+  if (room_temperature_sensor_ != nullptr && first_status_received_ &&
+      millis() - thermostat_at_ >= kThermostatIntervalInMilisec)
+    RunThermostat();
+}
+
+void Haier::dump_config() { stats_.Log(); }
+
+void Haier::DumpHistory() { engine_.RequestHistoryDump(); }
+
+void Haier::PublishStats() {
+  auto publish = [](Sensor *sensor, float value) {
+    if (sensor != nullptr)
+      sensor->publish_state(value);
+  };
+
+  publish(poll_rtt_sensor_, stats_.poll_rtt.mean());
+  publish(control_latency_sensor_, stats_.control_latency.mean());
+  publish(checksum_failures_sensor_, stats_.checksum_failures);
+  publish(temperature_rejects_sensor_, stats_.temperature_rejects);
+  publish(resyncs_sensor_, stats_.resyncs);
+  publish(dropped_bytes_sensor_, stats_.dropped_bytes);
+  publish(loop_time_sensor_, stats_.loop_time.max());
+}
+
+bool Haier::UpdateState(const StatusSnapshot &snapshot) {
+  bool changed = false;
+  const bool thermostat = room_temperature_sensor_ != nullptr;
+  if ((snapshot.changed_fields & StatusField::FieldCurrentTemperature) &&
+      (!thermostat || room_temperature_lost_))
+    changed |= UpdateCurrentTemperature(snapshot.current_temperature);
+  if (snapshot.changed_fields & StatusField::FieldFeatures) {
+    if (lock_sensor_ != nullptr)
+      lock_sensor_->publish_state(snapshot.lock);
+    if (fresh_sensor_ != nullptr)
+      fresh_sensor_->publish_state(snapshot.fresh);
+  }
+
+  return changed;
+}
+
+bool Haier::UpdateCurrentTemperature(float current_temperature) {
+  if (!std::isnan(Climate::current_temperature) &&
+      std::fabs(current_temperature - Climate::current_temperature) <
+          current_temperature_deadband_)
+    return false;
+
+  Climate::current_temperature = current_temperature;
+  return true;
+}
+
+bool Haier::ApplyState() {
+  const ClimateState &state = state_.published();
+  bool changed = Climate::mode != state.mode ||
+                 Climate::fan_mode != state.fan_mode ||
+                 Climate::swing_mode != state.swing_mode;
+  Climate::mode = state.mode;
+  Climate::fan_mode = state.fan_mode;
+  Climate::swing_mode = state.swing_mode;
+  // With the room thermostat the target is the user's and the AC set point
+  // only starts it off
+  const bool thermostat = room_temperature_sensor_ != nullptr;
+  if (!std::isnan(state.target_temperature) &&
+      (!thermostat || std::isnan(Climate::target_temperature))) {
+    changed |= Climate::target_temperature != state.target_temperature;
+    Climate::target_temperature = state.target_temperature;
+  }
+  changed |= UpdateFeatures(state);
+
+  const bool pending = state_.pending() != 0;
+  if (pending != pending_ && pending_sensor_ != nullptr)
+    pending_sensor_->publish_state(pending);
+  pending_ = pending;
+  return changed;
 }
 
-void Haier::update() { status_.SendPoll(); }
+bool Haier::UpdateFeatures(const ClimateState &state) {
+  auto publish = [](HaierFeatureSwitch &feature, bool on) {
+    if (feature.state != on)
+      feature.publish_state(on);
+  };
+  publish(quiet_switch_, state.quiet);
+  publish(fast_switch_, state.fast);
+  publish(purify_switch_, state.purify);
+
+  const bool changed = Climate::preset != state.preset();
+  Climate::preset = state.preset();
+  return changed;
+}
+
+void Haier::OnRoomTemperature(float room_temperature) {
+  if (std::isnan(room_temperature))
+    return;
+
+  room_temperature_ = room_temperature;
+  room_temperature_at_ = millis();
+  if (UpdateCurrentTemperature(room_temperature))
+    Climate::publish_state();
+}
+
+void Haier::RunThermostat() {
+  const uint32_t now = millis();
+  thermostat_at_ = now;
+
+  const bool regulating = Climate::mode == ClimateMode::CLIMATE_MODE_HEAT ||
+                          Climate::mode == ClimateMode::CLIMATE_MODE_COOL ||
+                          Climate::mode == ClimateMode::CLIMATE_MODE_HEAT_COOL;
+  if (!regulating || std::isnan(Climate::target_temperature)) {
+    thermostat_.Reset();
+    return;
+  }
+
+  const bool lost =
+      std::isnan(room_temperature_) ||
+      now - room_temperature_at_ >= kThermostatSensorTimeoutInMilisec;
+  if (lost != room_temperature_lost_) {
+    ESP_LOGW("EspHaier Thermostat", "Room temperature %s",
+             lost ? "lost, the AC regulates on its own" : "back");
+    room_temperature_lost_ = lost;
+  }
+
+  float set_point;
+  if (lost) {
+    thermostat_.Reset();
+    set_point = Control::SetPoint(Climate::target_temperature);
+  } else {
+    set_point = thermostat_.Update(Climate::target_temperature,
+                                   room_temperature_, now);
+  }
+
+  if (set_point == state_.actual().target_temperature)
+    return;
+  ESP_LOGD("EspHaier Thermostat", "Room %.1f, target %.1f, set point %.0f",
+           room_temperature_, Climate::target_temperature, set_point);
+  ControlRequest request;
+  request.target_temperature = set_point;
+  if (!engine_.Submit(request))
+    ESP_LOGW("EspHaier Thermostat", "Control queue full, set point dropped");
+}
 
 void Haier::control(const ClimateCall &call) {
   ESP_LOGD("EspHaier Control", "Control call");
 
-  if (!status_.GetFirstStatusReceived()) {
+  if (!first_status_received_) {
     ESP_LOGD("EspHaier Control", "No action, first poll answer not received");
     return;
   }
 
-  Control(status_, call).Send();
+  ControlRequest request = ControlRequest::FromCall(call);
+  if (room_temperature_sensor_ != nullptr) {
+    // Set point for the new target or mode on the next loop
+    thermostat_at_ = millis() - kThermostatIntervalInMilisec;
+  }
+  if (room_temperature_sensor_ != nullptr && request.target_temperature) {
+    // The user's target, the set point sent to the AC follows from it
+    Climate::target_temperature = *request.target_temperature;
+    target_preference_.save(&Climate::target_temperature);
+    request.target_temperature = esphome::optional<float>();
+    Climate::publish_state();
+  }
+  if (!request.IsEmpty())
+    Request(request);
 }
 
-ClimateTraits Haier::traits() {
-  auto traits = esphome::climate::ClimateTraits();
-  traits.set_supported_modes(
-      {ClimateMode::CLIMATE_MODE_OFF, ClimateMode::CLIMATE_MODE_HEAT_COOL,
-       ClimateMode::CLIMATE_MODE_HEAT, ClimateMode::CLIMATE_MODE_COOL,
-       ClimateMode::CLIMATE_MODE_DRY/*, ClimateMode::CLIMATE_MODE_FAN_ONLY*/});
+void Haier::Request(ControlRequest request) {
+  if (!first_status_received_) {
+    ESP_LOGD("EspHaier Control", "No action, first poll answer not received");
+    return;
+  }
 
-  traits.set_supported_fan_modes(
-      {ClimateFanMode::CLIMATE_FAN_AUTO, ClimateFanMode::CLIMATE_FAN_LOW,
-       ClimateFanMode::CLIMATE_FAN_MEDIUM, ClimateFanMode::CLIMATE_FAN_HIGH});
+  request.ResolveFanFeatures();
+  if (!engine_.Submit(request)) {
+    ESP_LOGW("EspHaier Control", "Control queue full, call dropped");
+    return;
+  }
+  if (state_.OnRequest(request, millis()) && ApplyState())
+    Climate::publish_state();
+}
+
+// Built once for the selected profile, traits() is called on every publish
+template <typename Profile> const ClimateTraits &GetProfileTraits() {
+  static const ClimateTraits traits = []() {
+    ClimateTraits traits;
+    std::set<ClimateMode> modes = {
+        ClimateMode::CLIMATE_MODE_OFF, ClimateMode::CLIMATE_MODE_HEAT_COOL,
+        ClimateMode::CLIMATE_MODE_HEAT, ClimateMode::CLIMATE_MODE_COOL,
+        ClimateMode::CLIMATE_MODE_DRY};
+    if (Profile::kFanOnlyMode)
+      modes.insert(ClimateMode::CLIMATE_MODE_FAN_ONLY);
+    traits.set_supported_modes(modes);
+
+    traits.set_supported_fan_modes(
+        {ClimateFanMode::CLIMATE_FAN_AUTO, ClimateFanMode::CLIMATE_FAN_LOW,
+         ClimateFanMode::CLIMATE_FAN_MEDIUM, ClimateFanMode::CLIMATE_FAN_HIGH});
+    // Quiet and fast, see ClimateState::preset()
+    traits.set_supported_presets({ClimatePreset::CLIMATE_PRESET_NONE,
+                                  ClimatePreset::CLIMATE_PRESET_BOOST,
+                                  ClimatePreset::CLIMATE_PRESET_SLEEP});
 
-  traits.set_visual_min_temperature(TempConstraints::MinSetTemperature);
-  traits.set_visual_max_temperature(TempConstraints::MaxSetTemperature);
-  traits.set_visual_temperature_step(1.0f);
-  traits.set_supports_current_temperature(true);
+    traits.set_visual_min_temperature(Profile::kMinSetTemperature);
+    traits.set_visual_max_temperature(Profile::kMaxSetTemperature);
+    traits.set_visual_temperature_step(1.0f);
+    traits.set_supports_current_temperature(true);
 
-  traits.set_supported_swing_modes(
-      {ClimateSwingMode::CLIMATE_SWING_OFF,
-       ClimateSwingMode::CLIMATE_SWING_BOTH,
-       ClimateSwingMode::CLIMATE_SWING_VERTICAL,
-       ClimateSwingMode::CLIMATE_SWING_HORIZONTAL});
+    if (Profile::kHorizontalSwing) {
+      traits.set_supported_swing_modes(
+          {ClimateSwingMode::CLIMATE_SWING_OFF,
+           ClimateSwingMode::CLIMATE_SWING_BOTH,
+           ClimateSwingMode::CLIMATE_SWING_VERTICAL,
+           ClimateSwingMode::CLIMATE_SWING_HORIZONTAL});
+    } else {
+      traits.set_supported_swing_modes(
+          {ClimateSwingMode::CLIMATE_SWING_OFF,
+           ClimateSwingMode::CLIMATE_SWING_VERTICAL});
+    }
+    return traits;
+  }();
   return traits;
-}
\ No newline at end of file
+}
+
+ClimateTraits Haier::traits() { return GetProfileTraits<ModelProfile>(); }
\ No newline at end of file
@@ -2,23 +2,151 @@
 
 #include "esphome.h"
 
-#include "status.h"
+#include "link_stats.h"
+#include "optimistic_state.h"
+#include "protocol_engine.h"
+#include "room_thermostat.h"
+#include "status_saver.h"
+#include "task_log.h"
+
+class Haier;
+
+// Custom switch for one of the quiet, fast and purify features. Changes made
+// before the control frame goes out are sent together in it.
+class HaierFeatureSwitch : public esphome::switch_::Switch {
+public:
+  HaierFeatureSwitch(Haier &haier,
+                     esphome::optional<bool> ControlRequest::*feature)
+      : haier_(haier), feature_(feature) {}
+
+protected:
+  void write_state(bool state) override;
+
+private:
+  Haier &haier_;
+  esphome::optional<bool> ControlRequest::*feature_;
+};
+
 class Haier : public esphome::climate::Climate,
-              public esphome::PollingComponent {
+              public esphome::Component,
+              public esphome::api::CustomAPIDevice {
 public:
-  Haier();
+  // Each unit needs its own hardware UART, e.g. Serial1 / Serial2 on ESP32
+  explicit Haier(HardwareSerial &uart = Serial);
+
+#ifdef ARDUINO_ARCH_ESP32
+  // UART pins, when not using the defaults of the UART
+  void set_uart_pins(int8_t rx_pin, int8_t tx_pin);
+#endif
+
+  // Polling intervals, see PollScheduler
+  void set_fast_poll_interval(uint32_t interval);
+  void set_fast_poll_duration(uint32_t duration);
+  void set_poll_interval(uint32_t interval);
+  void set_slow_poll_interval(uint32_t interval);
+  void set_stable_duration(uint32_t duration);
+  // Minimum change of the current temperature worth publishing
+  void set_current_temperature_deadband(float deadband);
+
+  // Optional link health sensors, see LinkStats
+  void set_poll_rtt_sensor(esphome::sensor::Sensor *sensor);
+  void set_control_latency_sensor(esphome::sensor::Sensor *sensor);
+  void set_checksum_failures_sensor(esphome::sensor::Sensor *sensor);
+  void set_temperature_rejects_sensor(esphome::sensor::Sensor *sensor);
+  void set_resyncs_sensor(esphome::sensor::Sensor *sensor);
+  void set_dropped_bytes_sensor(esphome::sensor::Sensor *sensor);
+  void set_loop_time_sensor(esphome::sensor::Sensor *sensor);
+  // On while a published state waits for the AC to confirm it
+  void set_pending_sensor(esphome::binary_sensor::BinarySensor *sensor);
+  // Room thermometer: when set, the unit regulates on it, see RoomThermostat.
+  // The climate then shows its temperature and the user's target, not the
+  // AC set point.
+  void set_room_temperature_sensor(esphome::sensor::Sensor *sensor);
+  // On while the AC answers, see LinkSupervisor
+  void set_connectivity_sensor(esphome::binary_sensor::BinarySensor *sensor);
+  // Optional, reported by the AC and not controllable
+  void set_lock_sensor(esphome::binary_sensor::BinarySensor *sensor);
+  void set_fresh_sensor(esphome::binary_sensor::BinarySensor *sensor);
+
+  // For a custom switch platform, also reachable through the presets
+  esphome::switch_::Switch *quiet_switch() { return &quiet_switch_; }
+  esphome::switch_::Switch *fast_switch() { return &fast_switch_; }
+  esphome::switch_::Switch *purify_switch() { return &purify_switch_; }
+
+  // Sends a request and publishes it right away, as control() does
+  void Request(ControlRequest request);
 
   // Climate overrides
   void setup() override;
   void loop() override;
+  void dump_config() override;
   void control(const esphome::climate::ClimateCall &call) override;
 
-  // PollingComponent overrides
-  void update() override;
-
 protected:
   esphome::climate::ClimateTraits traits() override;
 
 private:
-  Status status_;
+#ifdef ARDUINO_ARCH_ESP32
+  static void ProtocolTask(void *haier);
+#endif
+  void PublishStats();
+  // "dump_<name>_history" service, the history shows up in the logs
+  void DumpHistory();
+  // What only the status shows, the rest comes from state_
+  bool UpdateState(const StatusSnapshot &snapshot);
+  bool UpdateCurrentTemperature(float current_temperature);
+  // Copies the optimistic state into the climate and the switches
+  bool ApplyState();
+  bool UpdateFeatures(const ClimateState &state);
+  void OnRoomTemperature(float room_temperature);
+  void RunThermostat();
+
+  HardwareSerial &uart_;
+#ifdef ARDUINO_ARCH_ESP32
+  int8_t rx_pin_ = -1;
+  int8_t tx_pin_ = -1;
+#endif
+  // Runs on its own task on ESP32, from loop() elsewhere
+  ProtocolEngine engine_;
+#ifdef ARDUINO_ARCH_ESP32
+  // Log lines of the protocol task, printed from loop()
+  TaskLog task_log_;
+#endif
+  bool first_status_received_ = false;
+  esphome::optional<bool> connected_;
+
+  HaierFeatureSwitch quiet_switch_{*this, &ControlRequest::quiet};
+  HaierFeatureSwitch fast_switch_{*this, &ControlRequest::fast};
+  HaierFeatureSwitch purify_switch_{*this, &ControlRequest::purify};
+
+  esphome::sensor::Sensor *room_temperature_sensor_ = nullptr;
+  RoomThermostat thermostat_;
+  float room_temperature_ = NAN;
+  uint32_t room_temperature_at_ = 0;
+  uint32_t thermostat_at_ = 0;
+  bool room_temperature_lost_ = false;
+  // The user's target, the AC set point is not it
+  esphome::ESPPreferenceObject target_preference_;
+  float current_temperature_deadband_ = 0.0f;
+  LinkStats stats_;
+  // control() publishes the requested state right away, statuses clear it
+  // field by field, a rejection or a timeout rolls it back
+  OptimisticState state_;
+  // Last state of the pending sensor
+  bool pending_ = false;
+
+  esphome::ESPPreferenceObject preference_;
+  StatusSaver saver_;
+
+  esphome::sensor::Sensor *poll_rtt_sensor_ = nullptr;
+  esphome::sensor::Sensor *control_latency_sensor_ = nullptr;
+  esphome::sensor::Sensor *checksum_failures_sensor_ = nullptr;
+  esphome::sensor::Sensor *temperature_rejects_sensor_ = nullptr;
+  esphome::sensor::Sensor *resyncs_sensor_ = nullptr;
+  esphome::sensor::Sensor *dropped_bytes_sensor_ = nullptr;
+  esphome::sensor::Sensor *loop_time_sensor_ = nullptr;
+  esphome::binary_sensor::BinarySensor *pending_sensor_ = nullptr;
+  esphome::binary_sensor::BinarySensor *connectivity_sensor_ = nullptr;
+  esphome::binary_sensor::BinarySensor *lock_sensor_ = nullptr;
+  esphome::binary_sensor::BinarySensor *fresh_sensor_ = nullptr;
 };
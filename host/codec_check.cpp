@@ -0,0 +1,126 @@
+// Property checks for the frame codec: random frames (biased toward 0xFF and
+// 0x55 bytes) are escaped with encodeFrame(), mixed with line noise and
+// truncated frames, and must come out of FrameParser byte for byte. The only
+// frames allowed to be lost are the ones right after a truncated frame, whose
+// header may be taken as the missing bytes.
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "frame_parser.h"
+#include "utility.h"
+
+namespace {
+constexpr size_t kFrames = 200000;
+
+std::mt19937 random_engine(0x4A1E);
+
+byte RandomByte() {
+  switch (random_engine() % 4) {
+  case 0:
+    return kFrameHeader;
+  case 1:
+    return kFrameEscape;
+  default:
+    return random_engine();
+  }
+}
+
+std::vector<byte> RandomFrame() {
+  const byte length =
+      kMinFrameLength +
+      random_engine() % (kMaxFrameSize - kFrameOverhead - kCrc16Size -
+                         kMinFrameLength + 1);
+  const bool has_crc16 = random_engine() % 2;
+
+  std::vector<byte> frame = {kFrameHeader, kFrameHeader, length,
+                             static_cast<byte>(has_crc16 ? 0x40 : 0x00)};
+  while (frame.size() < length + kFrameOverhead)
+    frame.push_back(RandomByte());
+
+  const FrameChecksum checksum = computeChecksum(&frame[2], length);
+  frame.back() = checksum.sum;
+  if (has_crc16) {
+    frame.push_back(checksum.crc16 >> 8);
+    frame.push_back(checksum.crc16 & 0xFF);
+  }
+  return frame;
+}
+
+void Append(std::vector<byte> &wire, const std::vector<byte> &frame) {
+  encodeFrame(frame.data(), frame.size(), [&](const byte *chunk, size_t size) {
+    wire.insert(wire.end(), chunk, chunk + size);
+  });
+}
+} // namespace
+
+int main() {
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  std::vector<std::vector<byte>> frames;
+  std::vector<bool> after_truncated;
+  std::vector<byte> wire;
+
+  for (size_t i = 0; i < kFrames; i++) {
+    after_truncated.push_back(false);
+    switch (random_engine() % 8) {
+    case 0: {
+      // Noise without headers between frames
+      for (size_t noise = random_engine() % 16; noise > 0; noise--)
+        wire.push_back(random_engine() % kFrameHeader);
+      break;
+    }
+    case 1: {
+      // Frame cut short by the next one
+      std::vector<byte> truncated;
+      Append(truncated, RandomFrame());
+      truncated.resize(2 + random_engine() % (truncated.size() - 2));
+      if (truncated.back() == kFrameHeader)
+        truncated.pop_back();
+      wire.insert(wire.end(), truncated.begin(), truncated.end());
+      after_truncated.back() = true;
+      break;
+    }
+    }
+
+    frames.push_back(RandomFrame());
+    Append(wire, frames.back());
+  }
+
+  FrameParser parser;
+  size_t next = 0;
+  size_t decoded = 0;
+  size_t lost_after_truncated = 0;
+  for (byte value : wire) {
+    if (!parser.Feed(value) || next == frames.size())
+      continue;
+
+    const std::vector<byte> frame(parser.data(),
+                                  parser.data() + parser.size());
+    size_t match = next;
+    while (match < frames.size() && frame != frames[match] &&
+           after_truncated[match])
+      match++;
+    if (match == frames.size() || frame != frames[match])
+      continue;
+
+    lost_after_truncated += match - next;
+    decoded++;
+    next = match + 1;
+  }
+
+  const size_t lost = frames.size() - decoded - lost_after_truncated;
+  std::printf("%zu frames, %zu wire bytes, %zu decoded, %zu lost after a "
+              "truncated frame, %zu lost\n",
+              frames.size(), wire.size(), decoded, lost_after_truncated, lost);
+
+  if (lost > 0) {
+    std::fprintf(stderr, "Frames were lost or corrupted\n");
+    return 1;
+  }
+  return 0;
+}
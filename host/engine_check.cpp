@@ -0,0 +1,215 @@
+// Runs the protocol engine against the simulated AC, each scenario with its
+// own engine and AC. In the first one the engine runs on its own thread, the
+// way it runs on its own task on ESP32, while the main thread plays the
+// ESPHome loop: it waits for the first status, submits two control calls and
+// waits for the status showing them and for their result, printing the log
+// lines queued by the engine thread meanwhile. The others run on the main
+// thread: the persisted state is restored into a new engine, as after a
+// reboot, an engine loses its AC and gets it back, and two feature changes
+// go out in a single frame. Build with -fsanitize=thread to check the queues
+// between the two threads for data races.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "esphome.h"
+
+#include "protocol_engine.h"
+#include "simulated_ac.h"
+#include "task_log.h"
+
+using esphome::climate::ClimateCall;
+using esphome::climate::ClimateMode;
+
+namespace {
+constexpr uint32_t kTimeoutInMilisec = 60000;
+
+// Waits for a snapshot matching the predicate, false on timeout. Prints the
+// log lines of the engine thread meanwhile.
+template <typename Predicate>
+bool WaitForStatus(ProtocolEngine &engine, TaskLog &task_log,
+                   Predicate predicate, size_t &snapshots) {
+  const uint32_t start = millis();
+  StatusSnapshot snapshot;
+  while (millis() - start < kTimeoutInMilisec) {
+    task_log.Flush();
+    if (!engine.PopStatus(snapshot)) {
+      std::this_thread::yield();
+      continue;
+    }
+    snapshots++;
+    if (predicate(snapshot))
+      return true;
+  }
+  return false;
+}
+
+// Runs the engine for up to duration, true once done() is true
+template <typename Done>
+bool RunUntil(ProtocolEngine &engine, uint32_t duration, Done done) {
+  const uint32_t start = millis();
+  while (millis() - start < duration) {
+    engine.Loop();
+    if (done())
+      return true;
+    delay(1);
+  }
+  return false;
+}
+
+bool Report(const char *name, bool ok) {
+  std::printf("%s: %s\n", name, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// Control calls from the loop thread, confirmed by a status
+bool CheckThreadedControl() {
+  // The engine thread logs through a TaskLog, as on ESP32
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_DEBUG);
+
+  SimulatedAc ac;
+  ProtocolEngine engine(ac);
+  TaskLog task_log;
+  std::atomic<bool> stop{false};
+
+  engine.Start();
+  std::thread task([&]() {
+    task_log.Attach();
+    while (!stop) {
+      engine.Loop();
+      // vTaskDelay(1): a simulated millisecond, and the other thread gets
+      // to run even on a single core
+      delay(1);
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+  });
+
+  size_t snapshots = 0;
+  const bool first = WaitForStatus(
+      engine, task_log, [](const StatusSnapshot &) { return true; },
+      snapshots);
+
+  bool applied = false;
+  if (first) {
+    engine.Submit(ClimateCall().set_mode(ClimateMode::CLIMATE_MODE_COOL));
+    engine.Submit(ClimateCall().set_target_temperature(21));
+    applied = WaitForStatus(
+        engine, task_log,
+        [](const StatusSnapshot &snapshot) {
+          return snapshot.mode == ClimateMode::CLIMATE_MODE_COOL &&
+                 snapshot.target_temperature == 21;
+        },
+        snapshots);
+  }
+
+  const uint32_t start = millis();
+  ControlResult result = ControlResult::ControlExpired;
+  bool confirmed = false;
+  while (applied && !confirmed && millis() - start < kTimeoutInMilisec) {
+    task_log.Flush();
+    if (engine.PopResult(result))
+      confirmed = result == ControlResult::ControlConfirmed;
+    else
+      std::this_thread::yield();
+  }
+
+  stop = true;
+  task.join();
+  task_log.Flush();
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_WARN);
+
+  std::printf("%zu snapshots, first status %s, control %s, result %s\n",
+              snapshots, first ? "ok" : "FAILED", applied ? "ok" : "FAILED",
+              confirmed ? "ok" : "FAILED");
+  return Report("threaded control", first && applied && confirmed);
+}
+
+// The persisted state of one engine, restored into another before its first
+// poll
+bool CheckRestore() {
+  SimulatedAc ac;
+  ProtocolEngine engine(ac);
+  engine.Start();
+  StatusSnapshot snapshot;
+  bool ok =
+      RunUntil(engine, 2000, [&]() { return engine.PopStatus(snapshot); });
+  ok = ok &&
+       engine.Submit(ClimateCall().set_mode(ClimateMode::CLIMATE_MODE_COOL)) &&
+       engine.Submit(ClimateCall().set_target_temperature(21)) &&
+       RunUntil(engine, 2000, [&]() {
+         return engine.PopStatus(snapshot) &&
+                snapshot.mode == ClimateMode::CLIMATE_MODE_COOL &&
+                snapshot.target_temperature == 21;
+       });
+
+  PersistedStatus persisted;
+  bool persisted_any = false;
+  while (engine.PopPersisted(persisted))
+    persisted_any = true;
+
+  SimulatedAc rebooted_ac;
+  ProtocolEngine rebooted(rebooted_ac);
+  ok = ok && persisted_any && rebooted.Restore(persisted) &&
+       rebooted.PopStatus(snapshot) &&
+       snapshot.mode == ClimateMode::CLIMATE_MODE_COOL &&
+       snapshot.target_temperature == 21;
+  return Report("restore", ok);
+}
+
+// Switched off at the breaker for ten minutes: the link is reported down and
+// the polls back off, then it comes back by itself
+bool CheckLostLink() {
+  SimulatedAc ac;
+  ProtocolEngine engine(ac);
+  engine.Start();
+  const bool connected =
+      RunUntil(engine, 2000, [&]() { return engine.IsConnected(); });
+  ac.set_powered(false);
+  const size_t polls = ac.polls_received();
+  RunUntil(engine, 600000, []() { return false; });
+  const size_t lost_polls = ac.polls_received() - polls;
+  const bool down = !engine.IsConnected() && lost_polls < 20;
+  ac.set_powered(true);
+  const bool recovered =
+      RunUntil(engine, kLinkBackoffMaxInMilisec + kPollingIntervalInMilisec,
+               [&]() { return engine.IsConnected(); });
+
+  std::printf("%zu polls while off\n", lost_polls);
+  return Report("lost link", connected && down && recovered);
+}
+
+// Quiet and purify asked for one after the other, as two switches flipped by
+// one automation
+bool CheckFeatures() {
+  SimulatedAc ac;
+  ProtocolEngine engine(ac);
+  engine.Start();
+  StatusSnapshot snapshot;
+  bool ok =
+      RunUntil(engine, 2000, [&]() { return engine.PopStatus(snapshot); });
+  const size_t controls = ac.controls_received();
+  ControlRequest quiet;
+  quiet.quiet = true;
+  ControlRequest purify;
+  purify.purify = true;
+  ok = ok && engine.Submit(quiet) && engine.Submit(purify) &&
+       RunUntil(engine, 2000, [&]() {
+         return engine.PopStatus(snapshot) && snapshot.quiet &&
+                snapshot.purify;
+       });
+  const size_t frames = ac.controls_received() - controls;
+
+  std::printf("%zu control frames\n", frames);
+  return Report("features", ok && frames == 1);
+}
+} // namespace
+
+int main() {
+  bool ok = CheckThreadedControl();
+  ok &= CheckRestore();
+  ok &= CheckLostLink();
+  ok &= CheckFeatures();
+  return ok ? 0 : 1;
+}
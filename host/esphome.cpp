@@ -0,0 +1,65 @@
+#include "esphome.h"
+
+#include <atomic>
+#include <cstdio>
+
+namespace {
+std::atomic<uint32_t> now_ms{0};
+std::atomic<int> log_level{ESPHOME_LOG_LEVEL};
+
+char LevelLetter(int level) {
+  switch (level) {
+  case ESPHOME_LOG_LEVEL_ERROR:
+    return 'E';
+  case ESPHOME_LOG_LEVEL_WARN:
+    return 'W';
+  case ESPHOME_LOG_LEVEL_INFO:
+    return 'I';
+  case ESPHOME_LOG_LEVEL_DEBUG:
+    return 'D';
+  default:
+    return 'V';
+  }
+}
+} // namespace
+
+uint32_t millis() { return now_ms; }
+
+uint32_t micros() { return now_ms * 1000; }
+
+void delay(uint32_t ms) { now_ms += ms; }
+
+namespace esphome {
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format,
+                     ...) {
+  va_list args;
+  va_start(args, format);
+  esp_log_vprintf_(level, tag, line, format, args);
+  va_end(args);
+}
+
+void esp_log_vprintf_(int level, const char *tag, int line, const char *format,
+                      va_list args) {
+  if (level > log_level)
+    return;
+
+  std::fprintf(stderr, "[%8u][%c][%s:%03d]: ", now_ms.load(),
+               LevelLetter(level), tag, line);
+  std::vfprintf(stderr, format, args);
+  std::fputc('\n', stderr);
+}
+
+void set_host_log_level(int level) { log_level = level; }
+
+namespace logger {
+int Logger::level_for(const char *) { return log_level; }
+
+namespace {
+Logger host_logger;
+} // namespace
+
+Logger *global_logger = &host_logger;
+} // namespace logger
+
+} // namespace esphome
@@ -0,0 +1,184 @@
+#pragma once
+
+// Minimal stand-in for the parts of ESPHome / Arduino used by the protocol
+// code, so that src/ can be compiled and exercised natively on Linux. Only
+// what src/ actually uses lives here; the real headers are used on device.
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+
+using byte = uint8_t;
+using word = uint16_t;
+using uint16 = uint16_t;
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+
+#ifndef ESPHOME_LOG_LEVEL
+#define ESPHOME_LOG_LEVEL ESPHOME_LOG_LEVEL_DEBUG
+#endif
+
+#define ESP_LOGE(tag, format, ...)                                             \
+  esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_ERROR, tag, __LINE__, format,     \
+                           ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)                                             \
+  esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_WARN, tag, __LINE__, format,      \
+                           ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)                                             \
+  esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_INFO, tag, __LINE__, format,      \
+                           ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)                                             \
+  esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_DEBUG, tag, __LINE__, format,     \
+                           ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)                                             \
+  esphome::esp_log_printf_(ESPHOME_LOG_LEVEL_VERBOSE, tag, __LINE__, format,   \
+                           ##__VA_ARGS__)
+
+// Simulated clock, only moves when advanced by delay() or the host harness.
+// Safe to read from several threads.
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+// Arduino byte stream, implemented by HardwareSerial on device and by the
+// simulated UART on the host.
+class Stream {
+public:
+  virtual ~Stream() = default;
+
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+};
+
+namespace esphome {
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format,
+                     ...) __attribute__((format(printf, 4, 5)));
+void esp_log_vprintf_(int level, const char *tag, int line, const char *format,
+                      va_list args);
+
+// Log lines below this level are dropped, like the logger component does.
+void set_host_log_level(int level);
+
+namespace logger {
+// The runtime level of the logger component, the same for every tag here
+class Logger {
+public:
+  int level_for(const char *tag);
+};
+
+extern Logger *global_logger;
+} // namespace logger
+
+template <typename T> class optional {
+public:
+  optional() = default;
+  optional(const T &value) : value_(value), has_value_(true) {}
+
+  bool has_value() const { return has_value_; }
+  explicit operator bool() const { return has_value_; }
+  const T &operator*() const { return value_; }
+  const T &value() const { return value_; }
+
+private:
+  T value_{};
+  bool has_value_ = false;
+};
+
+namespace climate {
+
+enum ClimateMode : uint8_t {
+  CLIMATE_MODE_OFF = 0,
+  CLIMATE_MODE_HEAT_COOL = 1,
+  CLIMATE_MODE_COOL = 2,
+  CLIMATE_MODE_HEAT = 3,
+  CLIMATE_MODE_FAN_ONLY = 4,
+  CLIMATE_MODE_DRY = 5,
+  CLIMATE_MODE_AUTO = 6,
+};
+
+enum ClimateFanMode : uint8_t {
+  CLIMATE_FAN_ON = 0,
+  CLIMATE_FAN_OFF = 1,
+  CLIMATE_FAN_AUTO = 2,
+  CLIMATE_FAN_LOW = 3,
+  CLIMATE_FAN_MEDIUM = 4,
+  CLIMATE_FAN_HIGH = 5,
+  CLIMATE_FAN_MIDDLE = 6,
+  CLIMATE_FAN_FOCUS = 7,
+  CLIMATE_FAN_DIFFUSE = 8,
+};
+
+enum ClimateSwingMode : uint8_t {
+  CLIMATE_SWING_OFF = 0,
+  CLIMATE_SWING_BOTH = 1,
+  CLIMATE_SWING_VERTICAL = 2,
+  CLIMATE_SWING_HORIZONTAL = 3,
+};
+
+enum ClimatePreset : uint8_t {
+  CLIMATE_PRESET_NONE = 0,
+  CLIMATE_PRESET_HOME = 1,
+  CLIMATE_PRESET_AWAY = 2,
+  CLIMATE_PRESET_BOOST = 3,
+  CLIMATE_PRESET_COMFORT = 4,
+  CLIMATE_PRESET_ECO = 5,
+  CLIMATE_PRESET_SLEEP = 6,
+  CLIMATE_PRESET_ACTIVITY = 7,
+};
+
+class Climate;
+
+class ClimateCall {
+public:
+  explicit ClimateCall(Climate * = nullptr) {}
+
+  ClimateCall &set_mode(ClimateMode mode) {
+    mode_ = mode;
+    return *this;
+  }
+  ClimateCall &set_fan_mode(ClimateFanMode fan_mode) {
+    fan_mode_ = fan_mode;
+    return *this;
+  }
+  ClimateCall &set_swing_mode(ClimateSwingMode swing_mode) {
+    swing_mode_ = swing_mode;
+    return *this;
+  }
+  ClimateCall &set_target_temperature(float target_temperature) {
+    target_temperature_ = target_temperature;
+    return *this;
+  }
+  ClimateCall &set_preset(ClimatePreset preset) {
+    preset_ = preset;
+    return *this;
+  }
+
+  const optional<ClimateMode> &get_mode() const { return mode_; }
+  const optional<ClimateFanMode> &get_fan_mode() const { return fan_mode_; }
+  const optional<ClimateSwingMode> &get_swing_mode() const {
+    return swing_mode_;
+  }
+  const optional<float> &get_target_temperature() const {
+    return target_temperature_;
+  }
+  const optional<ClimatePreset> &get_preset() const { return preset_; }
+
+private:
+  optional<ClimateMode> mode_;
+  optional<ClimateFanMode> fan_mode_;
+  optional<ClimateSwingMode> swing_mode_;
+  optional<float> target_temperature_;
+  optional<ClimatePreset> preset_;
+};
+
+} // namespace climate
+} // namespace esphome
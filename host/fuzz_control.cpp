@@ -0,0 +1,127 @@
+// Fuzz target for the control encoder: a status taken from the input, then
+// arbitrary ClimateCall combinations (out of range enums and temperatures
+// included) applied on top of each other and sent. The control frame must
+// stay a valid frame with a set point the AC accepts.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esphome.h"
+
+#include "control.h"
+#include "status.h"
+#include "utility.h"
+
+using esphome::climate::ClimateCall;
+using esphome::climate::ClimateFanMode;
+using esphome::climate::ClimateMode;
+using esphome::climate::ClimateSwingMode;
+
+namespace {
+// Frames sent to it are checked, nothing is ever read back
+class CheckingStream : public Stream {
+public:
+  // Stream overrides
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t value) override { return write(&value, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    for (size_t i = 0; i < size; i++)
+      frames_ += buffer[i];
+    return size;
+  }
+
+private:
+  size_t frames_ = 0;
+};
+
+// Feeds a status frame built from the input to Status
+class StatusStream : public Stream {
+public:
+  explicit StatusStream(const StatusMessageType &status) {
+    encodeFrame(status.data(), status.size(),
+                [&](const byte *chunk, size_t size) {
+                  for (size_t i = 0; i < size; i++)
+                    wire_[size_++] = chunk[i];
+                });
+  }
+
+  // Stream overrides
+  int available() override { return size_ - position_; }
+  int read() override { return position_ < size_ ? wire_[position_++] : -1; }
+  int peek() override { return position_ < size_ ? wire_[position_] : -1; }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t *, size_t size) override { return size; }
+
+private:
+  byte wire_[2 * sizeof(StatusMessageType)];
+  size_t size_ = 0;
+  size_t position_ = 0;
+};
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  // The state the calls start from
+  StatusMessageType frame = GetStatusMessage();
+  const size_t body = std::min(size, frame.size() - 13);
+  if (body > 0)
+    std::memcpy(&frame[10], data, body);
+  data += body;
+  size -= body;
+  frame[0] = frame[1] = kFrameHeader;
+  frame[Offset::OffsetLength] = frame.size() - kFrameOverhead - kCrc16Size;
+  frame[Offset::OffsetFlags] = FrameFlags::FlagCrc16;
+  frame[Offset::OffsetCommand] = CommandType::CommandResponsePoll;
+  const FrameChecksum checksum = computeChecksum(&frame[2], frame[2]);
+  frame[frame.size() - 3] = checksum.sum;
+  frame[frame.size() - 2] = checksum.crc16 >> 8;
+  frame[frame.size() - 1] = checksum.crc16 & 0xFF;
+
+  StatusStream status_stream(frame);
+  Status status(status_stream);
+  status.OnPendingData();
+
+  CheckingStream uart;
+  Control control(status);
+  // One call per 6 bytes: which fields are set, then their values
+  while (size >= 6) {
+    ClimateCall call;
+    const byte mask = data[0];
+    if (mask & 0x01)
+      call.set_mode(static_cast<ClimateMode>(data[1] % 8));
+    if (mask & 0x02)
+      call.set_fan_mode(static_cast<ClimateFanMode>(data[2] % 10));
+    if (mask & 0x04)
+      call.set_swing_mode(static_cast<ClimateSwingMode>(data[3] % 5));
+    if (mask & 0x08) {
+      float temperature;
+      std::memcpy(&temperature, &data[2], sizeof(temperature));
+      call.set_target_temperature(temperature);
+    }
+    if (mask & 0x10)
+      control.UpdateFromStatus();
+    data += 6;
+    size -= 6;
+
+    control.Apply(call);
+    control.Send(uart);
+
+    const ControlMessagType &sent = control.frame();
+    const FrameView view(sent.data(), sent.size());
+    if (view.length() + kFrameOverhead + kCrc16Size != sent.size() ||
+        computeChecksum(&sent[2], view.length()).sum != view.checksum())
+      __builtin_trap();
+    if (call.get_target_temperature() &&
+        !std::isnan(*call.get_target_temperature()) &&
+        fields::SetTemperature::Get(sent) >
+            ModelProfile::kMaxSetTemperature - ModelProfile::kMinSetTemperature)
+      __builtin_trap();
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+// Stand-alone driver for the fuzz targets, for compilers without libFuzzer
+// (e.g. GCC with -fsanitize=address,undefined). Runs every file given, or
+// every file in the directories given, through LLVMFuzzerTestOneInput(), then
+// -n ITERATIONS random mutations of them (bytes flipped, inserted, removed,
+// inputs spliced) from a fixed seed.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+using Input = std::vector<uint8_t>;
+
+void Load(const std::string &path, std::vector<Input> &inputs) {
+  if (DIR *dir = opendir(path.c_str())) {
+    while (const dirent *entry = readdir(dir)) {
+      if (entry->d_name[0] != '.')
+        Load(path + "/" + entry->d_name, inputs);
+    }
+    closedir(dir);
+    return;
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  inputs.emplace_back(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+}
+
+Input Mutate(const std::vector<Input> &inputs, std::mt19937 &random) {
+  Input input = inputs[random() % inputs.size()];
+  for (unsigned mutations = 1 + random() % 8; mutations > 0; mutations--) {
+    const size_t position = input.empty() ? 0 : random() % input.size();
+    switch (random() % 5) {
+    case 0:
+      if (!input.empty())
+        input[position] ^= 1 << (random() % 8);
+      break;
+    case 1:
+      if (!input.empty())
+        input[position] = random() % 2 ? 0xFF : random();
+      break;
+    case 2:
+      input.insert(input.begin() + position, random());
+      break;
+    case 3:
+      if (!input.empty())
+        input.erase(input.begin() + position);
+      break;
+    default: {
+      const Input &other = inputs[random() % inputs.size()];
+      if (other.empty())
+        break;
+      const size_t start = random() % other.size();
+      const size_t end = start + random() % (other.size() - start + 1);
+      input.insert(input.begin() + position, other.begin() + start,
+                   other.begin() + end);
+    }
+    }
+  }
+  return input;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t iterations = 0;
+  std::vector<Input> inputs = {{}};
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      iterations = std::strtoul(argv[++i], nullptr, 10);
+    else
+      Load(argv[i], inputs);
+  }
+
+  for (const Input &input : inputs)
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+
+  std::mt19937 random(0x4A1E);
+  for (size_t i = 0; i < iterations; i++) {
+    const Input input = Mutate(inputs, random);
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+
+  std::printf("%zu inputs, %zu mutations\n", inputs.size(), iterations);
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Fuzz target for the receive path: arbitrary bytes from the UART go through
+// RxBuffer, FrameParser, the checksum checks, the FrameDispatcher and the
+// status decoding, in chunks as the driver would hand them over.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "esphome.h"
+
+#include "control.h"
+#include "rx_buffer.h"
+#include "status.h"
+
+namespace {
+volatile size_t sink;
+
+// Delivers the fuzz input a few bytes at a time
+class InputStream : public Stream {
+public:
+  InputStream(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  void Deliver(size_t count) { end_ = std::min(size_, end_ + count); }
+  bool done() const { return position_ == size_; }
+
+  // Stream overrides
+  int available() override { return end_ - position_; }
+  int read() override {
+    return position_ < end_ ? data_[position_++] : -1;
+  }
+  int peek() override { return position_ < end_ ? data_[position_] : -1; }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t *, size_t size) override { return size; }
+
+private:
+  const uint8_t *data_;
+  size_t size_;
+  size_t position_ = 0;
+  size_t end_ = 0;
+};
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  InputStream uart(data, size);
+  RxBuffer rx_buffer(uart);
+  Status status(rx_buffer);
+
+  // Reads every byte the view claims to have
+  size_t sum = 0;
+  status.dispatcher().set_unknown_handler([&](const FrameView &frame) {
+    sum += frame.length() + frame.command() + frame.checksum();
+    if (frame.has_crc16())
+      sum += frame.crc16();
+    for (size_t i = 0; i < frame.size(); i++)
+      sum += frame[i];
+  });
+
+  size_t chunk = 1;
+  while (!uart.done() || rx_buffer.available() > 0) {
+    // Chunk sizes up to the whole RX buffer, so it also overflows
+    uart.Deliver(chunk);
+    chunk = chunk * 7 % (kRxBufferSize + 13) + 1;
+    rx_buffer.Fill();
+
+    while (rx_buffer.available() > 0) {
+      if (!status.OnPendingData())
+        continue;
+
+      status.LogStatus();
+      sum += status.GetMode() + status.GetFanMode() + status.GetSwingMode() +
+             status.GetChangedFields();
+      Control control(status);
+      sum += Control::IsConfirmedBy(control.frame(), status);
+    }
+  }
+
+  sink = sum;
+  return 0;
+}
@@ -0,0 +1,126 @@
+// Runs the protocol code against the simulated AC: handshake, first poll,
+// two control calls (merged into one frame) and the poll confirming them,
+// then a fan speed change with the IR remote followed by a control call on
+// the stale status, which must keep it, and a fan speed change first seen in
+// a status rejected for its temperature, and two off calls in a row. Exits
+// non-zero when the AC did not end up in the expected state.
+
+#include <cstdio>
+
+#include "esphome.h"
+
+#include "initialization.h"
+#include "simulated_ac.h"
+#include "status.h"
+#include "tx_scheduler.h"
+
+using esphome::climate::ClimateCall;
+using esphome::climate::ClimateMode;
+
+namespace {
+bool Poll(Status &status) {
+  status.SendPoll();
+  delay(50);
+  if (!status.OnPendingData())
+    return false;
+
+  status.LogStatus();
+  std::printf("mode=%d fan=%d swing=%d current=%.1f target=%.1f\n",
+              status.GetMode(), status.GetFanMode(), status.GetSwingMode(),
+              status.GetCurrentTemperature(), status.GetTargetTemperature());
+  return true;
+}
+
+// The engine loop, polling when the scheduler asks for a fresh status
+void RunControl(Status &status, TxScheduler &tx_scheduler) {
+  while (!tx_scheduler.IsIdle()) {
+    delay(10);
+    if (tx_scheduler.NeedsRefresh(millis()) &&
+        tx_scheduler.CanTransmit(millis())) {
+      status.SendPoll();
+      tx_scheduler.OnTransmit();
+    }
+    tx_scheduler.Loop();
+    if (status.OnPendingData())
+      tx_scheduler.OnStatus();
+  }
+}
+} // namespace
+
+int main() {
+  SimulatedAc ac;
+  Status status(ac);
+
+  Initialization initialization(ac);
+  auto on_initialization = [&](const FrameView &frame) {
+    initialization.OnFrame(frame.command());
+  };
+  status.dispatcher().Register(CommandType::CommandDeviceVersionResponse,
+                               on_initialization);
+  status.dispatcher().Register(CommandType::CommandDeviceIdResponse,
+                               on_initialization);
+  initialization.Start();
+  while (!initialization.IsDone()) {
+    initialization.Loop();
+    delay(5);
+    status.OnPendingData();
+  }
+
+  if (!Poll(status)) {
+    std::fprintf(stderr, "No answer to the first poll\n");
+    return 1;
+  }
+
+  UnitScheduler unit_scheduler;
+  TxScheduler tx_scheduler(ac, status, unit_scheduler, status.stats());
+  tx_scheduler.Queue(ClimateCall().set_mode(ClimateMode::CLIMATE_MODE_COOL));
+  delay(20);
+  tx_scheduler.Queue(ClimateCall().set_target_temperature(21));
+  RunControl(status, tx_scheduler);
+
+  if (!Poll(status) || status.GetMode() != ClimateMode::CLIMATE_MODE_COOL ||
+      status.GetTargetTemperature() != 21) {
+    std::fprintf(stderr, "Control call was not applied\n");
+    return 1;
+  }
+
+  delay(kPollingIntervalInMilisec);
+  ac.set_fan_speed(FanMode::FanLow);
+  tx_scheduler.Queue(ClimateCall().set_target_temperature(23));
+  RunControl(status, tx_scheduler);
+
+  if (!Poll(status) || status.GetTargetTemperature() != 23 ||
+      status.GetFanSpeedStatus() != FanMode::FanLow) {
+    std::fprintf(stderr, "Control call overwrote the remote change\n");
+    return 1;
+  }
+
+  ac.set_fan_speed(FanMode::FanHigh);
+  ac.set_current_temperature(100);
+  if (Poll(status)) {
+    std::fprintf(stderr, "Status with an invalid temperature accepted\n");
+    return 1;
+  }
+  ac.set_current_temperature(24);
+  if (!Poll(status) ||
+      !(status.GetChangedFields() & StatusField::FieldFanMode)) {
+    std::fprintf(stderr, "Change in a rejected status was lost\n");
+    return 1;
+  }
+
+  // Off is off, also when asked again while already off
+  for (int i = 0; i < 2; i++) {
+    delay(kPollingIntervalInMilisec);
+    tx_scheduler.Queue(ClimateCall().set_mode(ClimateMode::CLIMATE_MODE_OFF));
+    RunControl(status, tx_scheduler);
+    if (!Poll(status) || status.GetPowerStatus()) {
+      std::fprintf(stderr, "Off call left the AC on\n");
+      return 1;
+    }
+  }
+
+  std::printf("polls=%zu controls=%zu\n", ac.polls_received(),
+              ac.controls_received());
+  status.stats().Log();
+  return 0;
+}
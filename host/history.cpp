@@ -0,0 +1,240 @@
+// Decodes the status history dumped by the "dump_<name>_history" service.
+//
+//   haier_history decode LOG
+//     Prints every frame of the history found in a log (the "history ..."
+//     lines, logger prefixes are ignored) with its time and the bytes that
+//     changed.
+//   haier_history check [-n ITERATIONS] TRACE|LOG...
+//     Records the status frames of captures into a StatusHistory, dumps and
+//     decodes it, and checks that the last frames come back exactly, with
+//     their times and the identical frames between them. The captures are
+//     recorded ITERATIONS times, and again until the ring is full, so that
+//     old entries get folded into the base. The dump is also written a few
+//     lines at a time, as the engine does, and must come out the same.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "esphome.h"
+
+#include "status.h"
+#include "status_history.h"
+#include "trace.h"
+
+namespace {
+// Bounds check on captures that are too short to ever fill the ring
+constexpr size_t kMaxIterations = 10000;
+
+struct HistoryFrame {
+  uint32_t time;
+  uint32_t repeats;
+  StatusHistory::Frame frame;
+};
+
+void AppendHex(const char *hex, std::vector<byte> &bytes) {
+  for (; hex[0] != '\0' && hex[1] != '\0'; hex += 2) {
+    const char digits[] = {hex[0], hex[1], '\0'};
+    bytes.push_back(std::strtoul(digits, nullptr, 16));
+  }
+}
+
+// Parses the dump lines, false when there is no complete dump
+bool Parse(const std::vector<std::string> &lines,
+           std::vector<HistoryFrame> &frames, uint32_t &repeats) {
+  unsigned frame_size = 0, base_time = 0, base_repeats = 0, entries = 0,
+           last_repeats = 0;
+  std::vector<byte> base, data;
+  bool started = false, ended = false;
+
+  for (const std::string &text : lines) {
+    const size_t start = text.find("history ");
+    if (start == std::string::npos)
+      continue;
+    const char *line = text.c_str() + start;
+
+    const bool v2 =
+        std::sscanf(line, "history v2 %u %u %u %u %u", &frame_size,
+                    &base_time, &base_repeats, &entries, &last_repeats) == 5;
+    if (v2 || std::sscanf(line, "history v1 %u %u %u %u", &frame_size,
+                          &base_time, &entries, &last_repeats) == 4) {
+      // v1 dumps did not have the repeats of the base
+      if (!v2)
+        base_repeats = 0;
+      started = true;
+      ended = false;
+      base.clear();
+      data.clear();
+    } else if (started && std::strncmp(line, "history b ", 10) == 0) {
+      AppendHex(line + 10, base);
+    } else if (started && std::strncmp(line, "history d ", 10) == 0) {
+      AppendHex(line + 10, data);
+    } else if (started && std::strncmp(line, "history end", 11) == 0) {
+      ended = true;
+    }
+  }
+
+  HistoryFrame current = {base_time, base_repeats, {}};
+  if (!ended || frame_size != current.frame.size() ||
+      base.size() != frame_size)
+    return false;
+  std::copy(base.begin(), base.end(), current.frame.begin());
+
+  frames = {current};
+  for (size_t offset = 0; offset < data.size();) {
+    const size_t size = StatusHistory::Decode(
+        [&](size_t i) { return data[offset + i]; }, data.size() - offset,
+        current.time, current.repeats, current.frame);
+    if (size == 0) {
+      std::fprintf(stderr, "Malformed entry at offset %zu\n", offset);
+      return false;
+    }
+    frames.push_back(current);
+    offset += size;
+  }
+  repeats = last_repeats;
+
+  if (frames.size() != entries + 1) {
+    std::fprintf(stderr, "%zu entries decoded, %u expected\n",
+                 frames.size() - 1, entries);
+    return false;
+  }
+  return true;
+}
+
+int Decode(int argc, char **argv) {
+  if (argc != 1) {
+    std::fprintf(stderr, "usage: haier_history decode LOG\n");
+    return 1;
+  }
+
+  std::ifstream file(argv[0]);
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(file, line);)
+    lines.push_back(line);
+
+  std::vector<HistoryFrame> frames;
+  uint32_t repeats;
+  if (!Parse(lines, frames, repeats)) {
+    std::fprintf(stderr, "No complete history in %s\n", argv[0]);
+    return 1;
+  }
+
+  const HistoryFrame *previous = nullptr;
+  for (const HistoryFrame &frame : frames) {
+    std::printf("%10u ms", (unsigned)frame.time);
+    if (frame.repeats > 0)
+      std::printf(" (after %u identical)", (unsigned)frame.repeats);
+    std::printf(":%s\n", HexDump(frame.frame).c_str());
+    for (size_t i = 0; previous != nullptr && i < frame.frame.size(); i++) {
+      if (frame.frame[i] != previous->frame[i])
+        std::printf("    byte %zu: 0x%02X -> 0x%02X\n", i, previous->frame[i],
+                    frame.frame[i]);
+    }
+    previous = &frame;
+  }
+  std::printf("%u identical frames since\n", (unsigned)repeats);
+  return 0;
+}
+
+bool Load(const std::string &path, Trace &trace) {
+  const bool is_trace =
+      path.size() > 6 && path.compare(path.size() - 6, 6, ".trace") == 0;
+  if (is_trace ? ReadTrace(path, trace) : ParseLog(path, trace))
+    return true;
+  std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+  return false;
+}
+
+int Check(int argc, char **argv) {
+  size_t iterations = 1;
+  Trace trace;
+  for (int i = 0; i < argc; i++) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      iterations = std::max(1l, std::atol(argv[++i]));
+    else if (!Load(argv[i], trace))
+      return 1;
+  }
+
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+  TraceStream stream(trace);
+  Status status(stream);
+  StatusHistory history;
+  // Every change with the identical frames before it, what must come back
+  std::vector<HistoryFrame> recorded;
+  uint32_t repeats = 0;
+
+  // Until something was evicted, unless the captures never change
+  auto evicted = [&]() { return recorded.size() > history.entries() + 1; };
+  for (size_t iteration = 0;
+       iteration < iterations || (!evicted() && recorded.size() > 1 &&
+                                  iteration < kMaxIterations);
+       iteration++) {
+    stream.Rewind();
+    while (stream.available() > 0) {
+      if (!status.OnPendingData())
+        continue;
+
+      delay(1000 + recorded.size() % 7);
+      history.Record(millis(), status.frame());
+      if (!recorded.empty() && recorded.back().frame == status.frame()) {
+        repeats++;
+        continue;
+      }
+      recorded.push_back({millis(), repeats, status.frame()});
+      repeats = 0;
+    }
+  }
+
+  std::vector<std::string> lines;
+  history.Dump([&](const char *line) { lines.push_back(line); });
+  // The engine dumps a few lines per loop
+  std::vector<std::string> chunked;
+  auto append = [&](const char *line) { chunked.push_back(line); };
+  size_t line = 0;
+  while (!history.Dump(append, line, kHistoryDumpLinesPerLoop) &&
+         line < lines.size())
+    line += kHistoryDumpLinesPerLoop;
+  if (chunked != lines) {
+    std::fprintf(stderr, "Dump in chunks of %zu lines differs\n",
+                 kHistoryDumpLinesPerLoop);
+    return 1;
+  }
+
+  std::vector<HistoryFrame> decoded;
+  uint32_t decoded_repeats;
+  if (!Parse(lines, decoded, decoded_repeats))
+    return 1;
+
+  bool match = evicted() && decoded.size() <= recorded.size() &&
+               decoded_repeats == repeats;
+  const size_t first = recorded.size() - decoded.size();
+  for (size_t i = 0; match && i < decoded.size(); i++) {
+    const HistoryFrame &expected = recorded[first + i];
+    match = decoded[i].frame == expected.frame &&
+            decoded[i].time == expected.time &&
+            decoded[i].repeats == expected.repeats;
+  }
+
+  std::printf("%zu changes recorded, %zu kept in %zu bytes (%zu dump lines), "
+              "%s\n",
+              recorded.size(), decoded.size(), history.used(), lines.size(),
+              match ? "ok" : evicted() ? "MISMATCH" : "nothing evicted");
+  return match ? 0 : 1;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc >= 2 && std::strcmp(argv[1], "decode") == 0)
+    return Decode(argc - 2, argv + 2);
+  if (argc >= 2 && std::strcmp(argv[1], "check") == 0)
+    return Check(argc - 2, argv + 2);
+
+  std::fprintf(stderr,
+               "usage: haier_history decode LOG\n"
+               "       haier_history check [-n ITERATIONS] TRACE|LOG...\n");
+  return 1;
+}
@@ -0,0 +1,235 @@
+// Replays captured wire traffic through the production decoding path.
+//
+//   haier_replay convert OUTPUT.trace LOG...
+//     Converts the text captures from data/ into a binary trace.
+//   haier_replay corpus DIRECTORY TRACE|LOG...
+//     Writes the captured wire bytes as a seed corpus for the fuzz targets,
+//     kCorpusRecords frames per file.
+//   haier_replay run [-v] [-n ITERATIONS] TRACE|LOG...
+//     Streams the frames through Status::OnPendingData() and prints the
+//     decoded state of every accepted status frame on stdout (for golden
+//     comparison) and throughput / per-frame latency and the link stats on
+//     stderr. Protocol logs are only printed with -v.
+//   haier_replay check GOLDEN TRACE|LOG...
+//     Decodes the frames like run and compares the state lines with GOLDEN,
+//     exits non-zero on the first difference. data/replay.golden holds the
+//     expected output for the Flexis captures in data/.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "esphome.h"
+
+#include "status.h"
+#include "trace.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kCorpusRecords = 16;
+
+bool EndsWith(const std::string &value, const std::string &suffix) {
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+bool Load(const std::string &path, Trace &trace) {
+  const bool loaded =
+      EndsWith(path, ".trace") ? ReadTrace(path, trace) : ParseLog(path, trace);
+  if (!loaded)
+    std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+  return loaded;
+}
+
+std::string FormatState(const Status &status) {
+  char line[80];
+  std::snprintf(line, sizeof(line),
+                "mode=%d fan=%d swing=%d current=%.1f target=%.1f",
+                status.GetMode(), status.GetFanMode(), status.GetSwingMode(),
+                status.GetCurrentTemperature(), status.GetTargetTemperature());
+  return line;
+}
+
+int Convert(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: haier_replay convert OUTPUT LOG...\n");
+    return 1;
+  }
+
+  Trace trace;
+  for (int i = 1; i < argc; i++) {
+    if (!Load(argv[i], trace))
+      return 1;
+  }
+
+  if (!WriteTrace(argv[0], trace)) {
+    std::fprintf(stderr, "Cannot write %s\n", argv[0]);
+    return 1;
+  }
+  std::fprintf(stderr, "%zu frames written to %s\n", trace.size(), argv[0]);
+  return 0;
+}
+
+int Corpus(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: haier_replay corpus DIRECTORY LOG...\n");
+    return 1;
+  }
+
+  Trace trace;
+  for (int i = 1; i < argc; i++) {
+    if (!Load(argv[i], trace))
+      return 1;
+  }
+
+  size_t files = 0;
+  for (size_t first = 0; first < trace.size(); first += kCorpusRecords) {
+    const std::string path =
+        std::string(argv[0]) + "/seed_" + std::to_string(files++);
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+      std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+      return 1;
+    }
+    const size_t last = std::min(trace.size(), first + kCorpusRecords);
+    for (size_t i = first; i < last; i++)
+      std::fwrite(trace[i].bytes.data(), 1, trace[i].bytes.size(), file);
+    std::fclose(file);
+  }
+  std::fprintf(stderr, "%zu seeds written to %s\n", files, argv[0]);
+  return 0;
+}
+
+int Run(int argc, char **argv) {
+  size_t iterations = 1;
+  bool verbose = false;
+  Trace trace;
+  for (int i = 0; i < argc; i++) {
+    if (std::strcmp(argv[i], "-v") == 0)
+      verbose = true;
+    else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      iterations = std::max(1l, std::atol(argv[++i]));
+    else if (!Load(argv[i], trace))
+      return 1;
+  }
+
+  if (!verbose)
+    esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  TraceStream stream(trace);
+  Status status(stream);
+  std::vector<double> latencies_ns;
+  const auto start = Clock::now();
+
+  for (size_t iteration = 0; iteration < iterations; iteration++) {
+    stream.Rewind();
+    while (stream.available() > 0) {
+      const auto frame_start = Clock::now();
+      const bool decoded = status.OnPendingData();
+      const auto frame_end = Clock::now();
+
+      if (!decoded)
+        continue;
+
+      latencies_ns.push_back(
+          std::chrono::duration<double, std::nano>(frame_end - frame_start)
+              .count());
+      if (iteration == 0)
+        std::printf("%s\n", FormatState(status).c_str());
+    }
+  }
+
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto percentile = [&](double p) {
+    if (latencies_ns.empty())
+      return 0.0;
+    return latencies_ns[static_cast<size_t>(p * (latencies_ns.size() - 1))];
+  };
+
+  std::fprintf(stderr,
+               "%zu records x %zu iterations: %zu status frames, %zu bytes in "
+               "%.3f s\n",
+               trace.size(), iterations, latencies_ns.size(),
+               stream.bytes_read(), seconds);
+  std::fprintf(stderr, "%.0f frames/s, %.0f bytes/s\n",
+               latencies_ns.size() / seconds, stream.bytes_read() / seconds);
+  std::fprintf(stderr,
+               "per-frame latency: p50 %.0f ns, p99 %.0f ns, max %.0f ns\n",
+               percentile(0.5), percentile(0.99), percentile(1.0));
+
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_INFO);
+  status.stats().Log();
+  return 0;
+}
+
+int Check(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: haier_replay check GOLDEN TRACE|LOG...\n");
+    return 1;
+  }
+
+  std::ifstream golden(argv[0]);
+  if (!golden) {
+    std::fprintf(stderr, "Cannot read %s\n", argv[0]);
+    return 1;
+  }
+  Trace trace;
+  for (int i = 1; i < argc; i++) {
+    if (!Load(argv[i], trace))
+      return 1;
+  }
+
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+  TraceStream stream(trace);
+  Status status(stream);
+  size_t frames = 0;
+  std::string expected;
+  while (stream.available() > 0) {
+    if (!status.OnPendingData())
+      continue;
+
+    frames++;
+    const std::string decoded = FormatState(status);
+    if (!std::getline(golden, expected) || decoded != expected) {
+      std::fprintf(stderr, "Status frame %zu: \"%s\", expected \"%s\"\n",
+                   frames, decoded.c_str(), golden ? expected.c_str() : "");
+      return 1;
+    }
+  }
+  if (std::getline(golden, expected)) {
+    std::fprintf(stderr, "Only %zu status frames decoded, more expected\n",
+                 frames);
+    return 1;
+  }
+
+  std::fprintf(stderr, "%zu status frames match %s\n", frames, argv[0]);
+  return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc >= 2 && std::strcmp(argv[1], "convert") == 0)
+    return Convert(argc - 2, argv + 2);
+  if (argc >= 2 && std::strcmp(argv[1], "corpus") == 0)
+    return Corpus(argc - 2, argv + 2);
+  if (argc >= 2 && std::strcmp(argv[1], "run") == 0)
+    return Run(argc - 2, argv + 2);
+  if (argc >= 2 && std::strcmp(argv[1], "check") == 0)
+    return Check(argc - 2, argv + 2);
+
+  std::fprintf(stderr,
+               "usage: haier_replay convert OUTPUT LOG...\n"
+               "       haier_replay corpus DIRECTORY LOG...\n"
+               "       haier_replay run [-v] [-n ITERATIONS] TRACE|LOG...\n"
+               "       haier_replay check GOLDEN TRACE|LOG...\n");
+  return 1;
+}
@@ -0,0 +1,176 @@
+// Checks of the receive buffer against a UART test double: overflow
+// accounting while loop() is stalled, arrival time of the frame headers, and
+// a producer thread filling the buffer while the parser drains it. Build
+// with -fsanitize=thread to check the buffer for data races.
+
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "frame_parser.h"
+#include "rx_buffer.h"
+#include "utility.h"
+
+namespace {
+constexpr size_t kThreadedFrames = 100000;
+
+// Driver side of the UART: bytes handed to it become available() at once
+class FakeUart : public Stream {
+public:
+  void Receive(const std::vector<byte> &bytes) {
+    pending_.insert(pending_.end(), bytes.begin(), bytes.end());
+  }
+
+  // Stream overrides
+  int available() override { return pending_.size(); }
+  int read() override {
+    const int value = peek();
+    if (value >= 0)
+      pending_.pop_front();
+    return value;
+  }
+  int peek() override { return pending_.empty() ? -1 : pending_.front(); }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t *, size_t size) override { return size; }
+
+private:
+  std::deque<byte> pending_;
+};
+
+std::vector<byte> Encode(const StatusMessageType &status) {
+  std::vector<byte> wire;
+  encodeFrame(status.data(), status.size(),
+              [&](const byte *chunk, size_t size) {
+                wire.insert(wire.end(), chunk, chunk + size);
+              });
+  return wire;
+}
+
+StatusMessageType MakeStatus(byte value) {
+  StatusMessageType status = GetStatusMessage();
+  status[0] = status[1] = kFrameHeader;
+  status[Offset::OffsetLength] = status.size() - kFrameOverhead;
+  status[Offset::OffsetCommand] = CommandType::CommandResponsePoll;
+  // An 0xFF in the body every other frame, to go through the escaping
+  status[Offset::OffsetSetTemperature] = value;
+  status[Offset::OffsetCurrentTemperature] = 0xFF - value;
+  status.back() = computeChecksum(&status[2], status.size() - 3).sum;
+  return status;
+}
+
+bool CheckOverflow() {
+  FakeUart uart;
+  RxBuffer buffer(uart);
+
+  // loop() stalled for longer than the buffer lasts
+  std::vector<byte> burst;
+  for (size_t i = 0; i < kRxBufferSize + 44; i++)
+    burst.push_back(i % kFrameHeader);
+  uart.Receive(burst);
+  buffer.Fill();
+
+  if (buffer.available() != static_cast<int>(kRxBufferSize) ||
+      buffer.overflows() != 44) {
+    std::fprintf(stderr, "overflow: %d buffered, %u lost\n",
+                 buffer.available(), buffer.overflows());
+    return false;
+  }
+  for (size_t i = 0; i < kRxBufferSize; i++) {
+    if (buffer.read() != static_cast<int>(i % kFrameHeader)) {
+      std::fprintf(stderr, "overflow: byte %zu out of order\n", i);
+      return false;
+    }
+  }
+  return buffer.read() == -1;
+}
+
+bool CheckFrameTime() {
+  FakeUart uart;
+  RxBuffer buffer(uart);
+  FrameParser parser;
+
+  // Both frames arrive before loop() gets to read them
+  uart.Receive(Encode(MakeStatus(0x10)));
+  buffer.Fill();
+  delay(40);
+  uart.Receive(Encode(MakeStatus(0xFF)));
+  buffer.Fill();
+  delay(500);
+
+  std::vector<uint32_t> times;
+  while (buffer.available() > 0) {
+    if (parser.Feed(buffer.read()))
+      times.push_back(buffer.frame_time());
+  }
+
+  if (times.size() != 2 || times[1] - times[0] != 40) {
+    std::fprintf(stderr, "frame time: %zu frames\n", times.size());
+    return false;
+  }
+  return true;
+}
+
+bool CheckThreaded() {
+  FakeUart uart;
+  RxBuffer buffer(uart);
+  std::atomic<bool> done{false};
+
+  // The UART callback, in bursts of a few frames. Like the real link it
+  // never outruns the consumer, so nothing may be lost.
+  std::thread producer([&]() {
+    const size_t burst = 3 * kMaxFrameSize;
+    for (size_t i = 0; i < kThreadedFrames; i++) {
+      uart.Receive(Encode(MakeStatus(i)));
+      if (i % 3 != 2)
+        continue;
+      while (buffer.available() > static_cast<int>(kRxBufferSize - burst))
+        std::this_thread::yield();
+      buffer.Fill();
+    }
+    buffer.Fill();
+    done = true;
+  });
+
+  FrameParser parser;
+  size_t decoded = 0;
+  size_t corrupted = 0;
+  while (!done || buffer.available() > 0) {
+    if (buffer.available() == 0)
+      std::this_thread::yield();
+    while (buffer.available() > 0) {
+      if (!parser.Feed(buffer.read()))
+        continue;
+
+      const StatusMessageType expected = MakeStatus(decoded % 256);
+      if (parser.size() == expected.size() &&
+          std::equal(expected.begin(), expected.end(), parser.data()))
+        decoded++;
+      else
+        corrupted++;
+    }
+  }
+  producer.join();
+
+  std::printf("threaded: %zu frames, %zu decoded, %zu corrupted, %u bytes "
+              "lost\n",
+              kThreadedFrames, decoded, corrupted, buffer.overflows());
+  return buffer.overflows() == 0 && decoded == kThreadedFrames;
+}
+} // namespace
+
+int main() {
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  const bool overflow = CheckOverflow();
+  const bool frame_time = CheckFrameTime();
+  const bool threaded = CheckThreaded();
+  std::printf("overflow %s, frame time %s, threaded %s\n",
+              overflow ? "ok" : "FAILED", frame_time ? "ok" : "FAILED",
+              threaded ? "ok" : "FAILED");
+  return overflow && frame_time && threaded ? 0 : 1;
+}
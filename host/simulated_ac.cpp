@@ -0,0 +1,113 @@
+#include "simulated_ac.h"
+
+#include <algorithm>
+#include <array>
+
+#include "fields.h"
+#include "utility.h"
+
+namespace {
+// Status captured from a Haier Flexis White Matt (poll.txt): power on, auto,
+// mid fan, 24 degrees set point and room temperature.
+constexpr std::array<byte, 47> kInitialStatus = {
+    0xFF, 0xFF, 0x2A, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x6D, 0x01,
+    0x08, 0x00, 0x02, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x30, 0x00,
+    0x45, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+constexpr byte kSubcommandPoll = 0x4D;
+constexpr byte kSubcommandControl = 0x60;
+
+// First and last byte a control frame can change in the status
+constexpr size_t kControlFirstByte = Offset::OffsetSetTemperature;
+constexpr size_t kControlLastByte = 21;
+} // namespace
+
+SimulatedAc::SimulatedAc() {
+  std::copy(kInitialStatus.begin(), kInitialStatus.end(), status_.begin());
+}
+
+int SimulatedAc::available() {
+  return std::count_if(pending_.begin(), pending_.end(),
+                       [](const std::pair<uint32_t, byte> &pending) {
+                         return pending.first <= millis();
+                       });
+}
+
+int SimulatedAc::read() {
+  const int value = peek();
+  if (value >= 0)
+    pending_.pop_front();
+  return value;
+}
+
+int SimulatedAc::peek() {
+  if (pending_.empty() || pending_.front().first > millis())
+    return -1;
+  return pending_.front().second;
+}
+
+size_t SimulatedAc::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (parser_.Feed(buffer[i]))
+      OnFrame(parser_.data(), parser_.size());
+  }
+  return size;
+}
+
+void SimulatedAc::set_current_temperature(byte current_temperature) {
+  status_[Offset::OffsetCurrentTemperature] = current_temperature * 2;
+}
+
+void SimulatedAc::set_fan_speed(byte fan_speed) {
+  fields::FanSpeed::Set(status_, fan_speed);
+}
+
+void SimulatedAc::OnFrame(const byte *frame, size_t size) {
+  const byte command = frame[Offset::OffsetCommand];
+  const bool poll =
+      command == 0x01 && frame[Offset::OffsetCommand + 1] == kSubcommandPoll;
+
+  if (poll)
+    polls_received_++;
+  if (!powered_)
+    return;
+
+  if (command == 0x01 &&
+      frame[Offset::OffsetCommand + 1] == kSubcommandControl &&
+      size > kControlLastByte) {
+    controls_received_++;
+    if (reject_controls_) {
+      std::array<byte, 13> invalid = {0xFF, 0xFF, 0x08, 0x40, 0x00, 0x00, 0x00,
+                                      0x00, 0x00, CommandInvalid};
+      Respond(invalid.data(), invalid.size());
+      return;
+    }
+    std::copy(frame + kControlFirstByte, frame + kControlLastByte + 1,
+              status_.begin() + kControlFirstByte);
+  } else if (!poll) {
+    // Every other request is acknowledged with command + 1 (0x61 -> 0x62,
+    // 0x73 -> 0x74, 0xFC -> 0xFD, ...).
+    std::array<byte, 13> ack = {0xFF, 0xFF, 0x08, 0x40, 0x00, 0x00, 0x00,
+                                0x00, 0x00, static_cast<byte>(command + 1)};
+    Respond(ack.data(), ack.size());
+    return;
+  }
+
+  Respond(status_.data(), status_.size());
+}
+
+void SimulatedAc::Respond(byte *frame, size_t size) {
+  const size_t offset = frame[Offset::OffsetLength] + 2u;
+
+  const FrameChecksum checksum = computeChecksum(frame + 2, offset - 2);
+  frame[offset] = checksum.sum;
+  frame[offset + 1] = (checksum.crc16 >> 8) & 0xFF;
+  frame[offset + 2] = checksum.crc16 & 0xFF;
+
+  const uint32_t ready_at = millis() + response_delay_;
+  encodeFrame(frame, size, [&](const byte *chunk, size_t chunk_size) {
+    for (size_t i = 0; i < chunk_size; i++)
+      pending_.emplace_back(ready_at, chunk[i]);
+  });
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "frame_parser.h"
+
+// Haier indoor unit answering on the other end of the UART. The protocol code
+// talks to it through the Stream interface: whatever it writes is parsed as
+// frames sent to the AC, and the AC replies become readable after
+// response_delay milliseconds of simulated time.
+class SimulatedAc : public Stream {
+public:
+  SimulatedAc();
+
+  // Stream overrides
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t value) override { return write(&value, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  void set_response_delay(uint32_t response_delay) {
+    response_delay_ = response_delay;
+  }
+  void set_current_temperature(byte current_temperature);
+  // A change made with the IR remote, FanMode value
+  void set_fan_speed(byte fan_speed);
+  // Switched off at the breaker: frames are still counted, never answered
+  void set_powered(bool powered) { powered_ = powered; }
+  // Control frames answered with 0x03 (invalid command), not applied
+  void set_reject_controls(bool reject_controls) {
+    reject_controls_ = reject_controls;
+  }
+
+  const StatusMessageType &status() const { return status_; }
+  size_t polls_received() const { return polls_received_; }
+  size_t controls_received() const { return controls_received_; }
+
+private:
+  void OnFrame(const byte *frame, size_t size);
+  void Respond(byte *frame, size_t size);
+
+  FrameParser parser_;
+  StatusMessageType status_;
+  std::deque<std::pair<uint32_t, byte>> pending_;
+  uint32_t response_delay_ = 15;
+  bool powered_ = true;
+  bool reject_controls_ = false;
+  size_t polls_received_ = 0;
+  size_t controls_received_ = 0;
+};
@@ -0,0 +1,259 @@
+// Checks the state the climate publishes around a control call: a control
+// the simulated AC rejects (0x03) rolls the published state back, so does a
+// status not showing it within kPendingStateTimeoutInMilisec, a status
+// showing part of it confirms that part only, and quiet and fast never end
+// up on together, nor stay on when a fan mode is picked. The flash writes of
+// the state are checked for their throttle too.
+
+#include <cmath>
+#include <cstdio>
+
+#include "esphome.h"
+
+#include "optimistic_state.h"
+#include "protocol_engine.h"
+#include "simulated_ac.h"
+#include "status_saver.h"
+
+using esphome::climate::ClimateCall;
+using esphome::climate::ClimateFanMode;
+using esphome::climate::ClimateMode;
+using esphome::climate::ClimatePreset;
+
+namespace {
+bool Report(const char *name, bool ok) {
+  std::printf("%s: %s\n", name, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+// Cooling at 24 degrees, mid fan, no feature on
+StatusSnapshot Snapshot() {
+  StatusSnapshot snapshot = {};
+  snapshot.mode = ClimateMode::CLIMATE_MODE_COOL;
+  snapshot.fan_mode = ClimateFanMode::CLIMATE_FAN_MEDIUM;
+  snapshot.current_temperature = 26;
+  snapshot.target_temperature = 24;
+  snapshot.changed_fields = StatusField::FieldAll;
+  return snapshot;
+}
+
+// Runs the engine for up to two seconds, feeding its statuses to the state,
+// true once done() is true
+template <typename Done>
+bool RunUntil(ProtocolEngine &engine, OptimisticState &state, Done done) {
+  StatusSnapshot snapshot;
+  for (uint32_t start = millis(); millis() - start < 2000; delay(1)) {
+    engine.Loop();
+    while (engine.PopStatus(snapshot))
+      state.OnStatus(snapshot);
+    if (done())
+      return true;
+  }
+  return false;
+}
+
+bool FirstStatus(ProtocolEngine &engine, OptimisticState &state) {
+  engine.Start();
+  return RunUntil(engine, state,
+                  [&]() { return state.actual().changed_fields != 0; });
+}
+
+// Through the engine, against an AC answering controls with 0x03
+bool CheckRejected() {
+  SimulatedAc ac;
+  ac.set_reject_controls(true);
+  ProtocolEngine engine(ac);
+  OptimisticState state;
+  if (!FirstStatus(engine, state))
+    return Report("rejected control", false);
+
+  ControlRequest request = ControlRequest::FromCall(
+      ClimateCall().set_mode(ClimateMode::CLIMATE_MODE_HEAT));
+  bool ok = engine.Submit(request) && state.OnRequest(request, millis()) &&
+            state.published().mode == ClimateMode::CLIMATE_MODE_HEAT &&
+            state.pending() == StatusField::FieldMode;
+
+  ControlResult result = ControlResult::ControlConfirmed;
+  ok = ok &&
+       RunUntil(engine, state, [&]() { return engine.PopResult(result); }) &&
+       result == ControlResult::ControlRejected &&
+       state.OnResult(result) && state.pending() == 0 &&
+       state.published().mode == state.actual().mode &&
+       state.published().mode != ClimateMode::CLIMATE_MODE_HEAT;
+  return Report("rejected control", ok);
+}
+
+bool CheckTimeout() {
+  OptimisticState state;
+  state.OnStatus(Snapshot());
+  ControlRequest request;
+  request.target_temperature = 20;
+  bool ok = state.OnRequest(request, 1000) &&
+            state.published().target_temperature == 20;
+
+  // A status not showing it keeps it published until the timeout
+  state.OnStatus(Snapshot());
+  ok = ok && !state.Loop(1000 + kPendingStateTimeoutInMilisec - 1) &&
+       state.published().target_temperature == 20 &&
+       state.Loop(1000 + kPendingStateTimeoutInMilisec) &&
+       state.published().target_temperature == 24 && state.pending() == 0 &&
+       !state.Loop(1000 + 2 * kPendingStateTimeoutInMilisec);
+  return Report("timeout", ok);
+}
+
+bool CheckPartialConfirmation() {
+  OptimisticState state;
+  state.OnStatus(Snapshot());
+  ControlRequest request;
+  request.mode = ClimateMode::CLIMATE_MODE_HEAT;
+  request.target_temperature = 28;
+  bool ok = state.OnRequest(request, 1000);
+
+  // Heating shows up first, with the old set point and the fan changed by
+  // the remote meanwhile
+  StatusSnapshot snapshot = Snapshot();
+  snapshot.mode = ClimateMode::CLIMATE_MODE_HEAT;
+  snapshot.fan_mode = ClimateFanMode::CLIMATE_FAN_HIGH;
+  state.OnStatus(snapshot);
+  ok = ok && state.pending() == StatusField::FieldTargetTemperature &&
+       state.published().mode == ClimateMode::CLIMATE_MODE_HEAT &&
+       state.published().fan_mode == ClimateFanMode::CLIMATE_FAN_HIGH &&
+       state.published().target_temperature == 28;
+
+  // Only the set point goes back, heating was confirmed
+  ok = ok && state.Loop(1000 + kPendingStateTimeoutInMilisec) &&
+       state.published().mode == ClimateMode::CLIMATE_MODE_HEAT &&
+       state.published().target_temperature == 24;
+
+  // Both fields shown: nothing left to roll back
+  state.OnRequest(request, 10000);
+  snapshot.target_temperature = 28;
+  state.OnStatus(snapshot);
+  ok = ok && state.pending() == 0 &&
+       !state.OnResult(ControlResult::ControlExpired) &&
+       state.published().target_temperature == 28;
+  return Report("partial confirmation", ok);
+}
+
+bool CheckFanFeatures() {
+  // Boost and sleep presets
+  ControlRequest boost = ControlRequest::FromCall(
+      ClimateCall().set_preset(ClimatePreset::CLIMATE_PRESET_BOOST));
+  ControlRequest none = ControlRequest::FromCall(
+      ClimateCall().set_preset(ClimatePreset::CLIMATE_PRESET_NONE));
+  bool ok = boost.fast && *boost.fast && boost.quiet && !*boost.quiet &&
+            none.fast && !*none.fast && none.quiet && !*none.quiet;
+
+  // Both switches turned on: the last one wins, as with the remote
+  ControlRequest both;
+  both.quiet = true;
+  both.fast = true;
+  both.ResolveFanFeatures();
+  ok = ok && *both.quiet && !*both.fast;
+
+  // Quiet alone while fast is on turns fast off
+  StatusSnapshot snapshot = Snapshot();
+  snapshot.fast = true;
+  OptimisticState state;
+  state.OnStatus(snapshot);
+  ok = ok && state.published().preset() == ClimatePreset::CLIMATE_PRESET_BOOST;
+  ControlRequest quiet;
+  quiet.quiet = true;
+  quiet.ResolveFanFeatures();
+  state.OnRequest(quiet, 1000);
+  ok = ok && state.published().quiet && !state.published().fast &&
+       state.published().preset() == ClimatePreset::CLIMATE_PRESET_SLEEP;
+
+  // Purify has no preset
+  ControlRequest purify;
+  purify.purify = true;
+  state.OnRequest(purify, 1000);
+  ok = ok && state.published().purify && state.published().quiet &&
+       state.published().preset() == ClimatePreset::CLIMATE_PRESET_SLEEP;
+  return Report("quiet and fast", ok);
+}
+
+// The AC reports low / high while quiet / fast is on, so a fan mode has to
+// turn them off to ever show up
+bool CheckFanModeWithFeature() {
+  SimulatedAc ac;
+  ProtocolEngine engine(ac);
+  OptimisticState state;
+  bool ok = FirstStatus(engine, state);
+
+  ControlRequest quiet;
+  quiet.quiet = true;
+  quiet.ResolveFanFeatures();
+  ok = ok && engine.Submit(quiet) && state.OnRequest(quiet, millis()) &&
+       RunUntil(engine, state, [&]() { return state.pending() == 0; }) &&
+       state.published().quiet &&
+       state.published().fan_mode == ClimateFanMode::CLIMATE_FAN_LOW;
+
+  ControlRequest high = ControlRequest::FromCall(
+      ClimateCall().set_fan_mode(ClimateFanMode::CLIMATE_FAN_HIGH));
+  high.ResolveFanFeatures();
+  const uint32_t now = millis();
+  ok = ok && engine.Submit(high) && state.OnRequest(high, now) &&
+       RunUntil(engine, state, [&]() { return state.pending() == 0; }) &&
+       !state.Loop(now + kPendingStateTimeoutInMilisec) &&
+       state.published().fan_mode == ClimateFanMode::CLIMATE_FAN_HIGH &&
+       !state.published().quiet && !state.published().fast;
+
+  // Unless the same request turns one on
+  ControlRequest both = high;
+  both.quiet = true;
+  both.ResolveFanFeatures();
+  ok = ok && *both.quiet && !*both.fast;
+  return Report("fan mode with quiet on", ok);
+}
+
+bool CheckSaveThrottle() {
+  StatusSaver saver;
+  PersistedStatus cooling = {};
+  cooling.fan_mode_setpoint = 24;
+  PersistedStatus heating = cooling;
+  heating.fan_mode_setpoint = 28;
+  saver.set_saved(cooling);
+
+  int saves = 0;
+  bool fail = false;
+  auto save = [&](const PersistedStatus &) {
+    saves++;
+    return !fail;
+  };
+
+  // Undone before the interval ran out: not written
+  saver.Update(heating);
+  saver.Update(cooling);
+  saver.Loop(kStatusSaveIntervalInMilisec, save);
+  bool ok = saves == 0;
+
+  // Written once the interval ran out, the failed write retried after another
+  saver.Update(heating);
+  fail = true;
+  saver.Loop(kStatusSaveIntervalInMilisec, save);
+  ok = ok && saves == 1 && saver.saved().fan_mode_setpoint == 24;
+  fail = false;
+  saver.Loop(2 * kStatusSaveIntervalInMilisec - 1, save);
+  ok = ok && saves == 1;
+  saver.Loop(2 * kStatusSaveIntervalInMilisec, save);
+  ok = ok && saves == 2 && saver.saved().fan_mode_setpoint == 28;
+
+  // Nothing new
+  saver.Loop(4 * kStatusSaveIntervalInMilisec, save);
+  ok = ok && saves == 2;
+  return Report("save throttle", ok);
+}
+} // namespace
+
+int main() {
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  bool ok = CheckRejected();
+  ok &= CheckTimeout();
+  ok &= CheckPartialConfirmation();
+  ok &= CheckFanFeatures();
+  ok &= CheckFanModeWithFeature();
+  ok &= CheckSaveThrottle();
+  return ok ? 0 : 1;
+}
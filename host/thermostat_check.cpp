@@ -0,0 +1,56 @@
+// Runs the room thermostat against a simple room model for a few hours of
+// simulated time: the AC holds its return air at the set point, which reads
+// kBias above the room, and the room loses heat to the outside. Without the
+// thermostat the room settles degrees away from the target; with it, the
+// room has to stay within kTolerance of the target once settled.
+
+#include <cmath>
+#include <cstdio>
+
+#include "esphome.h"
+
+#include "room_thermostat.h"
+
+namespace {
+constexpr float kBias = 2.0f;
+// Time constants in minutes, of the AC and of the heat loss
+constexpr float kAcMinutes = 20.0f;
+constexpr float kLossMinutes = 300.0f;
+constexpr int kSettleMinutes = 180;
+constexpr int kMeasureMinutes = 180;
+constexpr float kTolerance = 0.5f;
+
+bool Run(const char *name, float target, float outside, float room) {
+  RoomThermostat thermostat;
+  float worst = 0.0f, sum = 0.0f;
+  float set_point = target;
+  int changes = 0;
+
+  for (int minute = 0; minute < kSettleMinutes + kMeasureMinutes; minute++) {
+    const float previous = set_point;
+    set_point = thermostat.Update(target, room, minute * 60000u);
+    changes += minute >= kSettleMinutes && set_point != previous;
+    room += (set_point - kBias - room) / kAcMinutes +
+            (outside - room) / kLossMinutes;
+    if (minute >= kSettleMinutes) {
+      worst = std::fmax(worst, std::fabs(room - target));
+      sum += room - target;
+    }
+  }
+
+  const bool ok = worst <= kTolerance;
+  std::printf("%s: target %.1f, set point %.0f, mean error %+.2f, worst %.2f, "
+              "%d changes %s\n",
+              name, target, set_point, sum / kMeasureMinutes, worst, changes,
+              ok ? "ok" : "FAILED");
+  return ok;
+}
+} // namespace
+
+int main() {
+  esphome::set_host_log_level(ESPHOME_LOG_LEVEL_NONE);
+
+  bool ok = Run("heating", 21, 5, 15);
+  ok &= Run("cooling", 24, 32, 29);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+#include "trace.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+constexpr char kMagic[] = {'H', 'T', 'R', 'C'};
+constexpr byte kVersion = 1;
+
+bool ParseTimestamp(const std::string &line, uint32_t &timestamp_ms) {
+  // First "HH:MM:SS" followed by '.' or ':' and milliseconds
+  for (size_t i = 0; i + 12 <= line.size(); i++) {
+    unsigned hours, minutes, seconds, millis;
+    char separator;
+    if (std::sscanf(line.c_str() + i, "%2u:%2u:%2u%c%3u", &hours, &minutes,
+                    &seconds, &separator, &millis) == 5 &&
+        (separator == '.' || separator == ':') &&
+        std::isdigit(static_cast<unsigned char>(line[i]))) {
+      timestamp_ms = ((hours * 60 + minutes) * 60 + seconds) * 1000 + millis;
+      return true;
+    }
+  }
+  return false;
+}
+
+TraceDirection ParseDirection(const std::string &line) {
+  if (line.find("[Wifi to Haier]") != std::string::npos ||
+      line.find("Message sent") != std::string::npos)
+    return TraceDirectionToAc;
+  if (line.find("[Haier to Wifi]") != std::string::npos)
+    return TraceDirectionFromAc;
+  return TraceDirectionUnknown;
+}
+
+bool ParseToken(const std::string &token, int base, byte &value) {
+  if (token.empty() || token.size() > 3)
+    return false;
+  char *end = nullptr;
+  const long parsed = std::strtol(token.c_str(), &end, base);
+  if (*end != '\0' || parsed < 0 || parsed > 0xFF)
+    return false;
+  value = static_cast<byte>(parsed);
+  return true;
+}
+
+// Reads the frame bytes starting at the first "FF FF" / "255 255" token pair.
+bool ParseFrame(const std::string &line, std::vector<byte> &bytes) {
+  std::istringstream stream(line);
+  std::vector<std::string> tokens;
+  for (std::string token; stream >> token;)
+    tokens.push_back(token);
+
+  for (size_t i = 0; i + 1 < tokens.size(); i++) {
+    int base;
+    if ((tokens[i] == "FF" || tokens[i] == "ff") &&
+        (tokens[i + 1] == "FF" || tokens[i + 1] == "ff"))
+      base = 16;
+    else if (tokens[i] == "255" && tokens[i + 1] == "255")
+      base = 10;
+    else
+      continue;
+
+    byte value;
+    for (size_t j = i; j < tokens.size() && ParseToken(tokens[j], base, value);
+         j++)
+      bytes.push_back(value);
+    return true;
+  }
+  return false;
+}
+
+template <typename T> void Put(std::ofstream &out, T value) {
+  for (size_t i = 0; i < sizeof(T); i++)
+    out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+template <typename T> bool Get(std::ifstream &in, T &value) {
+  value = 0;
+  for (size_t i = 0; i < sizeof(T); i++) {
+    const int c = in.get();
+    if (c == EOF)
+      return false;
+    value |= static_cast<T>(static_cast<T>(c) << (8 * i));
+  }
+  return true;
+}
+} // namespace
+
+bool ParseLog(const std::string &path, Trace &trace) {
+  std::ifstream in(path);
+  if (!in)
+    return false;
+
+  uint32_t timestamp_ms = 0;
+  for (std::string line; std::getline(in, line);) {
+    TraceRecord record;
+    if (!ParseFrame(line, record.bytes))
+      continue;
+
+    ParseTimestamp(line, timestamp_ms);
+    record.timestamp_ms = timestamp_ms;
+    record.direction = ParseDirection(line);
+    trace.push_back(std::move(record));
+  }
+  return true;
+}
+
+bool WriteTrace(const std::string &path, const Trace &trace) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out)
+    return false;
+
+  out.write(kMagic, sizeof(kMagic));
+  out.put(static_cast<char>(kVersion));
+  for (const auto &record : trace) {
+    Put<uint32_t>(out, record.timestamp_ms);
+    Put<uint8_t>(out, record.direction);
+    Put<uint16_t>(out, record.bytes.size());
+    out.write(reinterpret_cast<const char *>(record.bytes.data()),
+              record.bytes.size());
+  }
+  return static_cast<bool>(out);
+}
+
+bool ReadTrace(const std::string &path, Trace &trace) {
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  if (!in.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), kMagic) ||
+      in.get() != kVersion)
+    return false;
+
+  TraceRecord record;
+  uint8_t direction;
+  uint16_t size;
+  while (Get(in, record.timestamp_ms)) {
+    if (!Get(in, direction) || !Get(in, size))
+      return false;
+    record.direction = static_cast<TraceDirection>(direction);
+    record.bytes.resize(size);
+    if (!in.read(reinterpret_cast<char *>(record.bytes.data()), size))
+      return false;
+    trace.push_back(record);
+  }
+  return true;
+}
+
+TraceStream::TraceStream(const Trace &trace) : trace_(trace) {
+  for (const auto &record : trace_)
+    size_ += record.bytes.size();
+}
+
+int TraceStream::available() { return size_ - position_in_trace_; }
+
+int TraceStream::read() {
+  const int value = peek();
+  if (value < 0)
+    return -1;
+
+  bytes_read_++;
+  position_in_trace_++;
+  position_++;
+  return value;
+}
+
+int TraceStream::peek() {
+  while (record_ < trace_.size() && position_ == trace_[record_].bytes.size()) {
+    record_++;
+    position_ = 0;
+  }
+  if (record_ == trace_.size())
+    return -1;
+  return trace_[record_].bytes[position_];
+}
+
+void TraceStream::Rewind() {
+  record_ = 0;
+  position_ = 0;
+  position_in_trace_ = 0;
+}
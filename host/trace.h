@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esphome.h"
+
+enum TraceDirection : uint8_t {
+  TraceDirectionUnknown = 0,
+  TraceDirectionToAc = 1,
+  TraceDirectionFromAc = 2,
+};
+
+// One frame as it was seen on the wire (escape bytes included).
+struct TraceRecord {
+  uint32_t timestamp_ms = 0;
+  TraceDirection direction = TraceDirectionUnknown;
+  std::vector<byte> bytes;
+};
+
+using Trace = std::vector<TraceRecord>;
+
+// Extracts frames from the captures in data/: hex dumps ("ff ff 0a 40 ..."),
+// decimal dumps ("255 255 42 64 ...") and the sniffer logs with timestamps
+// and "[Wifi to Haier]" / "[Haier to Wifi]" direction markers. Lines without
+// a frame are ignored. Records without a timestamp get the previous one.
+bool ParseLog(const std::string &path, Trace &trace);
+
+// Binary trace: "HTRC", version byte, then per record
+// timestamp (u32 LE), direction (u8), size (u16 LE) and the bytes.
+bool WriteTrace(const std::string &path, const Trace &trace);
+bool ReadTrace(const std::string &path, Trace &trace);
+
+// Plays the bytes of a trace back through the Stream interface, as the UART
+// would deliver them.
+class TraceStream : public Stream {
+public:
+  explicit TraceStream(const Trace &trace);
+
+  // Stream overrides
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t *, size_t size) override { return size; }
+
+  void Rewind();
+  size_t bytes_read() const { return bytes_read_; }
+
+private:
+  const Trace &trace_;
+  size_t record_ = 0;
+  size_t position_ = 0;
+  size_t size_ = 0;
+  size_t position_in_trace_ = 0;
+  size_t bytes_read_ = 0;
+};
@@ -5,6 +5,8 @@
 #include "esphome.h"
 
 enum Offset {
+  OffsetLength = 2,
+  OffsetFlags = 3,
   OffsetCommand = 9,
   OffsetSetTemperature = 12,
   OffsetVerticalSwing = 13,
@@ -77,8 +79,17 @@ enum FreshState {
   FreshStateOff = 0x00,
 };
 
+enum FrameFlags {
+  FlagCrc16 = 0x40,
+};
+
 enum CommandType {
+  CommandControl = 0x01,
   CommandResponsePoll = 0x02,
+  CommandInvalid = 0x03,
+  CommandConfirm = 0x05,
+  CommandDeviceVersionResponse = 0x62,
+  CommandDeviceIdResponse = 0x71,
 };
 
 enum PowerControl {
@@ -100,13 +111,106 @@ constexpr auto GetPollMessage = []() {
 };
 
 constexpr auto GetControlMessage = []() {
-  return std::array<byte, 26>({0xFF, 0xFF, 0x14, 0x40, 0x00, 0x00, 0x00,
+  return std::array<byte, 25>({0xFF, 0xFF, 0x14, 0x40, 0x00, 0x00, 0x00,
                                0x00, 0x00, 0x01, 0x60, 0x01, 0x00, 0x00,
                                0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
-                               0x00, 0x00, 0x00, 0x00, 0x00});
+                               0x00, 0x00, 0x00, 0x00});
 };
 
 constexpr uint32_t kPollingIntervalInMilisec = 5000;
+// Polling right after a control call, to pick up the confirmation quickly
+constexpr uint32_t kFastPollingIntervalInMilisec = 300;
+constexpr uint32_t kFastPollingDurationInMilisec = 3000;
+// Polling once the state has not changed for kStableDurationInMilisec
+constexpr uint32_t kSlowPollingIntervalInMilisec = 15000;
+constexpr uint32_t kStableDurationInMilisec = 60000;
+// Control calls arriving within this window are sent as a single frame
+constexpr uint32_t kControlCoalesceWindowInMilisec = 150;
+// Minimum time between two frames sent to the AC
+constexpr uint32_t kMinFrameGapInMilisec = 100;
+constexpr uint32_t kControlConfirmTimeoutInMilisec = 1000;
+constexpr uint8_t kControlMaxRetries = 2;
+// A frame acknowledged by the AC is not resent, it waits this long for the
+// status showing it (as long as the retries would have taken)
+constexpr uint32_t kControlAckedTimeoutInMilisec =
+    kControlConfirmTimeoutInMilisec * (kControlMaxRetries + 1);
+// A control frame is built on a status at most this old, a poll refreshes an
+// older one first unless the answer takes longer than the refresh timeout
+constexpr uint32_t kControlStatusMaxAgeInMilisec = 1000;
+constexpr uint32_t kControlRefreshTimeoutInMilisec = 500;
+// A state published ahead of the AC is rolled back when no status shows it
+// within this time, long enough for the retries and a fast poll
+constexpr uint32_t kPendingStateTimeoutInMilisec = 5000;
+// Spacing between frames sent by different units driven from the same board,
+// about the time a status frame takes at 9600 baud
+constexpr uint32_t kUnitStaggerInMilisec = 50;
+constexpr uint32_t kInitializationTimeoutInMilisec = 500;
+constexpr uint8_t kInitializationMaxRetries = 3;
+// Unanswered polls in a row before the link is reported as missing / lost,
+// see LinkSupervisor
+constexpr uint8_t kLinkMissingPolls = 2;
+constexpr uint8_t kLinkLostPolls = 4;
+// Handshake retries on a lost link, doubling up to the maximum
+constexpr uint32_t kLinkBackoffMinInMilisec = 10000;
+constexpr uint32_t kLinkBackoffMaxInMilisec = 300000;
+// Room thermostat, see RoomThermostat. The set point is reconsidered at this
+// interval, and the AC regulates on its own when the room sensor has not
+// reported for the timeout.
+constexpr uint32_t kThermostatIntervalInMilisec = 60000;
+constexpr uint32_t kThermostatSensorTimeoutInMilisec = 600000;
+constexpr float kThermostatGain = 1.0f;
+constexpr float kThermostatIntegralGainPerMinute = 0.05f;
+constexpr float kThermostatMaxOffset = 4.0f;
+// Past the rounding to whole degrees, against flipping between two set points
+constexpr float kThermostatHysteresis = 0.25f;
+// Link health sensors are published at this interval
+constexpr uint32_t kStatsPublishIntervalInMilisec = 60000;
+// Minimum time between two writes of the persisted status to flash
+constexpr uint32_t kStatusSaveIntervalInMilisec = 60000;
+// Part of the preference key, to be bumped when PersistedStatus changes
+constexpr uint32_t kPersistedStatusVersion = 1;
+// Part of the preference key of the room thermostat target
+constexpr uint32_t kThermostatTargetPreference = 0x100;
+
+constexpr byte kFrameHeader = 0xFF;
+// Sent after every 0xFF following the header, see encodeFrame()
+constexpr byte kFrameEscape = 0x55;
+// Header (FF FF) and the additive checksum are not counted in the length byte
+constexpr size_t kFrameOverhead = 3;
+constexpr size_t kCrc16Size = 2;
+constexpr size_t kMinFrameLength = 0x08;
+constexpr size_t kMaxFrameSize = 64;
+// Commands that can have a handler in the FrameDispatcher
+constexpr size_t kMaxFrameHandlers = 8;
+// Received bytes waiting for loop(), a few status frames worth
+constexpr size_t kRxBufferSize = 256;
+// Frame headers with an arrival time, matching kRxBufferSize
+constexpr size_t kRxBoundaries = 8;
+// Status history per unit, about a thousand changes in a few kilobytes
+constexpr size_t kStatusHistorySize = 4096;
+constexpr size_t kStatusHistoryLineBytes = 32;
+// Queues between the protocol engine and the ESPHome loop
+constexpr size_t kControlQueueSize = 4;
+constexpr size_t kStatusQueueSize = 4;
+// Protocol task on ESP32, above the loop task and on its core (WiFi runs on
+// the other one where there are two)
+constexpr uint32_t kProtocolTaskStackSize = 4096;
+constexpr uint32_t kProtocolTaskPriority = 5;
+#ifdef ARDUINO_ARCH_ESP32
+#ifdef CONFIG_ARDUINO_RUNNING_CORE
+constexpr int kProtocolTaskCore = CONFIG_ARDUINO_RUNNING_CORE;
+#else
+// Single core variants (S2, C3, C6) only have core 0
+constexpr int kProtocolTaskCore = portNUM_PROCESSORS > 1 ? 1 : 0;
+#endif
+#endif
+// Log lines of the protocol task waiting for the ESPHome loop, enough for the
+// lines of a status change. A status frame takes about 170 characters.
+constexpr size_t kTaskLogQueueSize = 32;
+constexpr size_t kTaskLogLineSize = 192;
+// History dump lines logged per engine loop, the rest waits for the next
+// ones instead of holding up polling and retries
+constexpr size_t kHistoryDumpLinesPerLoop = 8;
 
 constexpr auto GetStatusMessage = []() { return std::array<byte, 47>(); };
 
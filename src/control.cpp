@@ -1,53 +1,134 @@
 #include "control.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "esphome.h"
 
+#include "fields.h"
+#include "task_log.h"
 #include "utility.h"
 
-using esphome::esp_log_printf_;
 using esphome::climate::ClimateCall;
 using esphome::climate::ClimateMode;
 using esphome::climate::ClimateFanMode;
+using esphome::climate::ClimatePreset;
 using esphome::climate::ClimateSwingMode;
 
-Control::Control(const Status &status, const ClimateCall &call)
-    : status_(status), call_(call) {
-  UpdateFromStatus();
-  UpdateFromHomeAssitant();
+ControlRequest ControlRequest::FromCall(const ClimateCall &call) {
+  ControlRequest request;
+  request.mode = call.get_mode();
+  request.fan_mode = call.get_fan_mode();
+  request.swing_mode = call.get_swing_mode();
+  request.target_temperature = call.get_target_temperature();
+  if (call.get_preset())
+    request.SetPreset(*call.get_preset());
+  return request;
+}
+
+ClimateCall ControlRequest::ToCall() const {
+  ClimateCall call(nullptr);
+  if (mode)
+    call.set_mode(*mode);
+  if (fan_mode)
+    call.set_fan_mode(*fan_mode);
+  if (swing_mode)
+    call.set_swing_mode(*swing_mode);
+  if (target_temperature)
+    call.set_target_temperature(*target_temperature);
+  return call;
+}
+
+void ControlRequest::Merge(const ControlRequest &later) {
+  if (later.mode)
+    mode = later.mode;
+  if (later.fan_mode)
+    fan_mode = later.fan_mode;
+  if (later.swing_mode)
+    swing_mode = later.swing_mode;
+  if (later.target_temperature)
+    target_temperature = later.target_temperature;
+  if (later.quiet)
+    quiet = later.quiet;
+  if (later.fast)
+    fast = later.fast;
+  if (later.purify)
+    purify = later.purify;
+}
+
+void ControlRequest::SetPreset(ClimatePreset preset) {
+  quiet = preset == ClimatePreset::CLIMATE_PRESET_SLEEP;
+  fast = preset == ClimatePreset::CLIMATE_PRESET_BOOST;
+}
+
+void ControlRequest::ResolveFanFeatures() {
+  if (quiet && *quiet)
+    fast = false;
+  else if (fast && *fast)
+    quiet = false;
+
+  // The status reports low / high while they are on, never the fan mode
+  if (fan_mode) {
+    if (!quiet)
+      quiet = false;
+    if (!fast)
+      fast = false;
+  }
 }
 
-void Control::Send() { sendData(control_command_); }
+Control::Control(const Status &status) : status_(status) { UpdateFromStatus(); }
 
 void Control::UpdateFromStatus() {
-  SetPowerControl(status_.GetPowerStatus());
-  SetHvacModeControl(status_.GetHvacModeStatus());
-  SetPurifyControl(status_.GetPurifyStatus());
-  SetQuietModeControl(status_.GetQuietModeStatus());
-  SetFastModeControl(status_.GetFastModeStatus());
-  SetFanSpeedControl(status_.GetFanSpeedStatus());
-  SetHorizontalSwingControl(status_.GetHorizontalSwingStatus());
-  SetVerticalSwingControl(status_.GetVerticalSwingStatus());
-  SetTemperatureSetpointControl(status_.GetTemperatureSetpointStatus());
+  ControlFields::Copy(status_.frame(), control_command_);
+}
+
+void Control::Apply(const ClimateCall &call) {
+  HandleClimateMode(call);
+  HandleFanSpeedMode(call);
+  HandleSwingMode(call);
+  HandleTargetTemperature(call);
 }
 
-void Control::UpdateFromHomeAssitant() {
-  HandleClimateMode();
-  HandleFanSpeedMode();
-  HandleSwingMode();
-  HandleTargetTemperature();
+void Control::ApplyFeatures(const ControlRequest &request) {
+  if (request.quiet)
+    SetQuietModeControl(*request.quiet);
+  if (request.fast)
+    SetFastModeControl(*request.fast);
+  if (request.purify)
+    SetPurifyControl(*request.purify);
 }
 
-void Control::HandleClimateMode() {
-  auto mode = call_.get_mode();
+void Control::Send(Stream &uart) { sendData(uart, control_command_); }
+
+bool Control::IsConfirmedBy(const ControlMessagType &frame,
+                            const Status &status) {
+  // Values the unit reports back as set, the rest only matter while on
+  using ConfirmedFields =
+      FieldList<fields::Purify, fields::Quiet, fields::FanMax,
+                fields::HvacMode, fields::FanSpeed, fields::SetTemperature,
+                fields::HorizontalSwing, fields::VerticalSwing>;
+
+  const bool power = fields::Power::Get(frame);
+
+  if (power != status.GetPowerStatus())
+    return false;
+  if (!power)
+    return true;
+
+  return ConfirmedFields::Equal(frame, status.frame());
+}
+
+void Control::HandleClimateMode(const ClimateCall &call) {
+  auto mode = call.get_mode();
 
   if (!mode)
     return;
 
-  ESP_LOGD("EspHaier Control", "mode = %d", *mode);
+  HAIER_LOGD("EspHaier Control", "mode = %d", *mode);
 
   switch (*mode) {
   case ClimateMode::CLIMATE_MODE_OFF:
-    SetPowerControl(!status_.GetPowerStatus());
+    SetPowerControl(false);
     break;
 
   case ClimateMode::CLIMATE_MODE_HEAT_COOL:
@@ -86,18 +167,18 @@ void Control::HandleClimateMode() {
     break;
 
   default:
-    ESP_LOGE("EspHaier Control", "Unhandled mode : %d", *mode);
+    HAIER_LOGE("EspHaier Control", "Unhandled mode : %d", *mode);
     break;
   }
 }
 
-void Control::HandleFanSpeedMode() {
-  auto fan_mode = call_.get_fan_mode();
+void Control::HandleFanSpeedMode(const ClimateCall &call) {
+  auto fan_mode = call.get_fan_mode();
 
   if (!fan_mode)
     return;
 
-  ESP_LOGD("EspHaier Control", "fan_mode = %d", *fan_mode);
+  HAIER_LOGD("EspHaier Control", "fan_mode = %d", *fan_mode);
 
   switch (*fan_mode) {
   case ClimateFanMode::CLIMATE_FAN_AUTO:
@@ -113,99 +194,100 @@ void Control::HandleFanSpeedMode() {
     SetFanSpeedControl(FanMode::FanHigh);
     break;
   default:
-    ESP_LOGE("EspHaier Control", "Unhandled fan mode : %d", *fan_mode);
+    HAIER_LOGE("EspHaier Control", "Unhandled fan mode : %d", *fan_mode);
     break;
   }
 }
 
-void Control::HandleSwingMode() {
-  auto swing_mode = call_.get_swing_mode();
+void Control::HandleSwingMode(const ClimateCall &call) {
+  auto swing_mode = call.get_swing_mode();
 
   if (!swing_mode)
     return;
 
-  ESP_LOGD("EspHaier Control", "swing_mode = %d", *swing_mode);
+  HAIER_LOGD("EspHaier Control", "swing_mode = %d", *swing_mode);
 
   switch (*swing_mode) {
   case ClimateSwingMode::CLIMATE_SWING_OFF:
-    SetHorizontalSwingControl(HorizontalSwingMode::HorizontalSwingCenter);
-    SetVerticalSwingControl(VerticalSwingMode::VerticalSwingCenter);
+    SetHorizontalSwingControl(ModelProfile::kHorizontalSwingOff);
+    SetVerticalSwingControl(ModelProfile::kVerticalSwingOff);
     break;
   case ClimateSwingMode::CLIMATE_SWING_VERTICAL:
-    SetHorizontalSwingControl(HorizontalSwingMode::HorizontalSwingCenter);
-    SetVerticalSwingControl(VerticalSwingMode::VerticalSwingAuto);
+    SetHorizontalSwingControl(ModelProfile::kHorizontalSwingOff);
+    SetVerticalSwingControl(ModelProfile::kVerticalSwingAuto);
     break;
   case ClimateSwingMode::CLIMATE_SWING_HORIZONTAL:
-    SetHorizontalSwingControl(HorizontalSwingMode::HorizontalSwingAuto);
-    SetVerticalSwingControl(VerticalSwingMode::VerticalSwingCenter);
+    SetHorizontalSwingControl(ModelProfile::kHorizontalSwingAuto);
+    SetVerticalSwingControl(ModelProfile::kVerticalSwingOff);
     break;
   case ClimateSwingMode::CLIMATE_SWING_BOTH:
-    SetHorizontalSwingControl(HorizontalSwingMode::HorizontalSwingAuto);
-    SetVerticalSwingControl(VerticalSwingMode::VerticalSwingAuto);
+    SetHorizontalSwingControl(ModelProfile::kHorizontalSwingAuto);
+    SetVerticalSwingControl(ModelProfile::kVerticalSwingAuto);
     break;
   }
 }
 
-void Control::HandleTargetTemperature() {
-  auto temp = call_.get_target_temperature();
+void Control::HandleTargetTemperature(const ClimateCall &call) {
+  auto temp = call.get_target_temperature();
 
   if (!temp)
     return;
 
-  ESP_LOGD("EspHaier Control", "*call.get_target_temperature() = %f", *temp);
+  HAIER_LOGD("EspHaier Control", "*call.get_target_temperature() = %f", *temp);
 
   SetPointOffset(*temp);
 }
 
 void Control::SetHvacModeControl(byte mode) {
-  control_command_[Offset::OffsetMode] &= ~AcMode::ModeMask;
-  control_command_[Offset::OffsetMode] |= mode;
+  fields::HvacMode::Set(control_command_, mode);
 }
 
 void Control::SetTemperatureSetpointControl(byte temp) {
-  control_command_[Offset::OffsetSetTemperature] = temp;
+  fields::SetTemperature::Set(control_command_, temp);
 }
 
 void Control::SetFanSpeedControl(byte fan_mode) {
-  control_command_[Offset::OffsetMode] &= ~FanMode::FanMask;
-  control_command_[Offset::OffsetMode] |= fan_mode;
+  fields::FanSpeed::Set(control_command_, fan_mode);
 }
 
 void Control::SetHorizontalSwingControl(byte swing_mode) {
-  control_command_[Offset::OffsetHorizontalSwing] = swing_mode;
+  fields::HorizontalSwing::Set(control_command_, swing_mode);
 }
 
 void Control::SetVerticalSwingControl(byte swing_mode) {
-  control_command_[Offset::OffsetVerticalSwing] = swing_mode;
+  fields::VerticalSwing::Set(control_command_, swing_mode);
 }
 
 void Control::SetQuietModeControl(bool quiet_mode) {
-  ApplyStatusDataField(quiet_mode, DataField::DataFieldQuiet);
+  fields::Quiet::Set(control_command_, quiet_mode);
 }
 
 void Control::SetPurifyControl(bool purify_mode) {
-  ApplyStatusDataField(purify_mode, DataField::DataFieldPurify);
+  fields::Purify::Set(control_command_, purify_mode);
 }
 
 void Control::SetPowerControl(bool power_mode) {
-  ApplyStatusDataField(power_mode, DataField::DataFieldPower);
+  fields::Power::Set(control_command_, power_mode);
 }
 
 void Control::SetFastModeControl(bool fast_mode) {
-  ApplyStatusDataField(fast_mode, DataField::DataFieldFanMax);
+  fields::FanMax::Set(control_command_, fast_mode);
 }
 
 void Control::SetPointOffset(float temp) {
-  control_command_[Offset::OffsetSetTemperature] = (uint16)temp - 16;
+  // Converting an out of range float is undefined, and the AC only takes
+  // offsets within the profile range anyway
+  if (std::isnan(temp)) {
+    HAIER_LOGW("EspHaier Control", "Invalid target temperature");
+    return;
+  }
+  fields::SetTemperature::Set(control_command_, (uint16)SetPoint(temp) - 16);
 }
 
-void Control::ApplyStatusDataField(bool state, byte field) {
-  byte msk = (0x01 << field);
-
-  if (state) {
-    control_command_[Offset::OffsetStatusData] |= msk;
-  } else {
-    msk = ~msk;
-    control_command_[Offset::OffsetStatusData] &= msk;
-  }
-}
\ No newline at end of file
+float Control::SetPoint(float temp) {
+  if (std::isnan(temp))
+    return temp;
+  temp = std::min(std::max(temp, ModelProfile::kMinSetTemperature),
+                  ModelProfile::kMaxSetTemperature);
+  return std::floor(temp);
+}
@@ -5,20 +5,59 @@
 #include "constants.h"
 #include "status.h"
 
+// The fields a control call sets. ClimateCall keeps a const pointer to its
+// climate, so it cannot be stored in a queue slot or a member itself. The
+// features have no ClimateCall counterpart (presets and switches map to
+// them), so requests from several sources are merged into one frame.
+struct ControlRequest {
+  esphome::optional<esphome::climate::ClimateMode> mode;
+  esphome::optional<esphome::climate::ClimateFanMode> fan_mode;
+  esphome::optional<esphome::climate::ClimateSwingMode> swing_mode;
+  esphome::optional<float> target_temperature;
+  esphome::optional<bool> quiet;
+  esphome::optional<bool> fast;
+  esphome::optional<bool> purify;
+
+  static ControlRequest FromCall(const esphome::climate::ClimateCall &call);
+  esphome::climate::ClimateCall ToCall() const;
+  // The fields set by a later request win
+  void Merge(const ControlRequest &later);
+  // Boost is fast, sleep is quiet, any other preset turns both off
+  void SetPreset(esphome::climate::ClimatePreset preset);
+  // Both are fan speeds, turning one on turns the other off, and a fan mode
+  // turns off the ones the request does not set
+  void ResolveFanFeatures();
+  bool IsEmpty() const {
+    return !mode && !fan_mode && !swing_mode && !target_temperature &&
+           !quiet && !fast && !purify;
+  }
+};
+
 class Control {
 public:
-  Control(const Status &status, const esphome::climate::ClimateCall &call);
+  explicit Control(const Status &status);
 
-  void Send();
-
-private:
+  // Starts over from the last received status
   void UpdateFromStatus();
-  void UpdateFromHomeAssitant();
+  // Applies a call on top of the current frame, several calls can be merged
+  void Apply(const esphome::climate::ClimateCall &call);
+  // Quiet, fast and purify, all in the status data byte of the same frame
+  void ApplyFeatures(const ControlRequest &request);
+  void Send(Stream &uart);
 
-  void HandleClimateMode();
-  void HandleFanSpeedMode();
-  void HandleSwingMode();
-  void HandleTargetTemperature();
+  const ControlMessagType &frame() const { return control_command_; }
+
+  // True when the status reports the state requested by the frame
+  static bool IsConfirmedBy(const ControlMessagType &frame,
+                            const Status &status);
+  // Target temperature the AC ends up with for a requested one
+  static float SetPoint(float temp);
+
+private:
+  void HandleClimateMode(const esphome::climate::ClimateCall &call);
+  void HandleFanSpeedMode(const esphome::climate::ClimateCall &call);
+  void HandleSwingMode(const esphome::climate::ClimateCall &call);
+  void HandleTargetTemperature(const esphome::climate::ClimateCall &call);
 
   void SetHvacModeControl(byte mode);
   void SetTemperatureSetpointControl(byte temp);
@@ -30,9 +69,7 @@ private:
   void SetPowerControl(bool power_mode);
   void SetFastModeControl(bool fast_mode);
   void SetPointOffset(float temp);
-  void ApplyStatusDataField(bool state, byte field);
 
   const Status &status_;
-  const esphome::climate::ClimateCall &call_;
   ControlMessagType control_command_ = GetControlMessage();
 };
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "profiles.h"
+
+// User-visible values a status frame can change
+enum StatusField {
+  FieldMode = 0x01,
+  FieldFanMode = 0x02,
+  FieldSwingMode = 0x04,
+  FieldCurrentTemperature = 0x08,
+  FieldTargetTemperature = 0x10,
+  // Quiet, fast, purify, lock and fresh
+  FieldFeatures = 0x20,
+  FieldAll = 0x3F,
+};
+
+// Describes where a value lives in a frame. Status and control frames share
+// the offsets, taken from the ModelProfile, so one descriptor decodes the
+// status and encodes the control frame. Changes is the StatusField mask a
+// change of the value affects.
+template <byte ByteOffset, byte Mask, byte Shift = 0, typename Type = byte,
+          byte Changes = 0>
+struct Field {
+  static constexpr byte kOffset = ByteOffset;
+  static constexpr byte kMask = Mask;
+  static constexpr byte kChanges = Changes;
+  static_assert(((Mask >> Shift) << Shift) == Mask, "Shift drops mask bits");
+
+  template <typename Frame> static constexpr Type Get(const Frame &frame) {
+    return static_cast<Type>((frame[kOffset] & kMask) >> Shift);
+  }
+
+  template <typename Frame>
+  static constexpr void Set(Frame &frame, Type value) {
+    frame[kOffset] = (frame[kOffset] & ~kMask) |
+                     ((static_cast<byte>(value) << Shift) & kMask);
+  }
+
+  template <typename Frame>
+  static constexpr bool Changed(const Frame &frame, const Frame &other) {
+    return (frame[kOffset] ^ other[kOffset]) & kMask;
+  }
+
+  // Every value the mask can hold survives Set() then Get(), and Set() leaves
+  // the bits outside the mask alone
+  static constexpr bool RoundTrips() {
+    for (unsigned value = 0; value <= (Mask >> Shift); value++) {
+      if (value & ~(Mask >> Shift))
+        continue;
+      std::array<byte, kMaxFrameSize> frame = {};
+      frame[kOffset] = 0xA5;
+      Set(frame, static_cast<Type>(value));
+      if (static_cast<byte>(Get(frame)) != static_cast<byte>(value) ||
+          (frame[kOffset] & ~kMask) != (0xA5 & ~kMask))
+        return false;
+    }
+    return true;
+  }
+};
+
+template <typename... Fields> struct FieldList {
+  // StatusField mask of the values that differ between two frames
+  template <typename Frame>
+  static constexpr byte Diff(const Frame &frame, const Frame &other) {
+    return ((Fields::Changed(frame, other) ? Fields::kChanges : 0) | ... | 0);
+  }
+
+  template <typename From, typename To>
+  static constexpr void Copy(const From &from, To &to) {
+    (Fields::Set(to, Fields::Get(from)), ...);
+  }
+
+  template <typename Frame, typename Other>
+  static constexpr bool Equal(const Frame &frame, const Other &other) {
+    return ((Fields::Get(frame) == Fields::Get(other)) && ...);
+  }
+
+  static constexpr bool RoundTrips() { return (Fields::RoundTrips() && ...); }
+};
+
+namespace fields {
+using P = ModelProfile;
+
+using Power = Field<P::kOffsetStatusData, 0x01 << DataFieldPower,
+                    DataFieldPower, bool,
+                    FieldMode | FieldFanMode | FieldSwingMode>;
+using Purify = Field<P::kOffsetStatusData, 0x01 << DataFieldPurify,
+                     DataFieldPurify, bool, FieldFeatures>;
+using Quiet = Field<P::kOffsetStatusData, 0x01 << DataFieldQuiet,
+                    DataFieldQuiet, bool, FieldFanMode | FieldFeatures>;
+using FanMax = Field<P::kOffsetStatusData, 0x01 << DataFieldFanMax,
+                     DataFieldFanMax, bool, FieldFanMode | FieldFeatures>;
+using HvacMode = Field<P::kOffsetMode, ModeMask, 0, byte, FieldMode>;
+using FanSpeed = Field<P::kOffsetMode, FanMask, 0, byte, FieldFanMode>;
+using SetTemperature =
+    Field<P::kOffsetSetTemperature, 0xFF, 0, byte, FieldTargetTemperature>;
+using VerticalSwing =
+    Field<P::kOffsetVerticalSwing, 0xFF, 0, byte, FieldSwingMode>;
+using HorizontalSwing =
+    Field<P::kOffsetHorizontalSwing, 0xFF, 0, byte, FieldSwingMode>;
+using CurrentTemperature =
+    Field<P::kOffsetCurrentTemperature, 0xFF, 0, byte, FieldCurrentTemperature>;
+using Lock = Field<P::kOffsetLock, LockStateOn, 0, byte, FieldFeatures>;
+using Fresh = Field<P::kOffsetFresh, FreshkStateOn, 0, bool, FieldFeatures>;
+} // namespace fields
+
+// Everything decoded from a status frame
+using StatusFields =
+    FieldList<fields::Power, fields::Purify, fields::Quiet, fields::FanMax,
+              fields::HvacMode, fields::FanSpeed, fields::SetTemperature,
+              fields::VerticalSwing, fields::HorizontalSwing,
+              fields::CurrentTemperature, fields::Lock, fields::Fresh>;
+
+// What a control frame sets, taken over from the status before a call is
+// applied
+using ControlFields =
+    FieldList<fields::Power, fields::Purify, fields::Quiet, fields::FanMax,
+              fields::HvacMode, fields::FanSpeed, fields::SetTemperature,
+              fields::VerticalSwing, fields::HorizontalSwing>;
+
+static_assert(StatusFields::RoundTrips(), "Field layout does not round-trip");
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "esphome.h"
+
+#include "constants.h"
+
+// Read-only view of a received frame, sized by its length byte. It points
+// into the parser buffer, so it is only valid until the next byte is parsed.
+class FrameView {
+public:
+  FrameView(const byte *data, size_t size) : data_(data), size_(size) {}
+
+  const byte *data() const { return data_; }
+  size_t size() const { return size_; }
+  byte operator[](size_t offset) const { return data_[offset]; }
+
+  byte length() const { return data_[Offset::OffsetLength]; }
+  byte command() const { return data_[Offset::OffsetCommand]; }
+  bool has_crc16() const {
+    return data_[Offset::OffsetFlags] & FrameFlags::FlagCrc16;
+  }
+  byte checksum() const { return data_[length() + 2u]; }
+  word crc16() const {
+    return (data_[length() + 3u] << 8) | data_[length() + 4u];
+  }
+
+private:
+  const byte *data_;
+  size_t size_;
+};
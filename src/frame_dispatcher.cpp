@@ -0,0 +1,35 @@
+#include "frame_dispatcher.h"
+
+#include "esphome.h"
+
+#include "task_log.h"
+
+FrameDispatcher::FrameDispatcher() { handler_index_.fill(kNoHandler); }
+
+bool FrameDispatcher::Register(byte command, Handler handler) {
+  byte index = handler_index_[command];
+
+  if (index == kNoHandler) {
+    if (handler_count_ == handlers_.size()) {
+      HAIER_LOGE("EspHaier Dispatcher", "No room for a handler of 0x%X",
+                 command);
+      return false;
+    }
+    index = handler_count_++;
+    handler_index_[command] = index;
+  }
+
+  handlers_[index] = handler;
+  return true;
+}
+
+void FrameDispatcher::Dispatch(const FrameView &frame) const {
+  const byte index = handler_index_[frame.command()];
+
+  if (index != kNoHandler)
+    handlers_[index](frame);
+  else if (unknown_handler_)
+    unknown_handler_(frame);
+  else
+    HAIER_LOGD("EspHaier Dispatcher", "Unhandled frame 0x%X", frame.command());
+}
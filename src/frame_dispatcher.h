@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <functional>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "frame.h"
+
+// Routes received frames to the handler registered for their command byte.
+// The lookup is a 256-entry table of handler indexes, so dispatching is
+// constant time while only kMaxFrameHandlers handlers take RAM.
+class FrameDispatcher {
+public:
+  using Handler = std::function<void(const FrameView &frame)>;
+
+  FrameDispatcher();
+
+  bool Register(byte command, Handler handler);
+  // Called for commands without a handler
+  void set_unknown_handler(Handler handler) { unknown_handler_ = handler; }
+
+  void Dispatch(const FrameView &frame) const;
+
+private:
+  static constexpr byte kNoHandler = 0xFF;
+
+  std::array<byte, 256> handler_index_;
+  std::array<Handler, kMaxFrameHandlers> handlers_;
+  size_t handler_count_ = 0;
+  Handler unknown_handler_;
+};
@@ -0,0 +1,107 @@
+#include "frame_parser.h"
+
+#include "esphome.h"
+
+#include "task_log.h"
+
+bool FrameParser::Feed(byte value) {
+  switch (state_) {
+  case StateHeader1:
+    if (value == kFrameHeader) {
+      state_ = StateHeader2;
+    } else if (!escape_ || value != kFrameEscape) {
+      dropped_bytes_++;
+    }
+    escape_ = false;
+    return false;
+
+  case StateHeader2:
+    if (value == kFrameHeader) {
+      StartFrame();
+    } else {
+      dropped_bytes_ += 2;
+      state_ = StateHeader1;
+    }
+    return false;
+
+  case StateLength:
+    // FF FF FF... is the start of another header, stay aligned on it
+    if (value == kFrameHeader) {
+      dropped_bytes_++;
+      return false;
+    }
+
+    if (value < kMinFrameLength ||
+        value + kFrameOverhead + kCrc16Size > buffer_.size()) {
+      HAIER_LOGW("EspHaier Parser", "Invalid frame length 0x%X, resyncing",
+                 value);
+      Resync(size_ + 1);
+      Reset();
+      return false;
+    }
+    buffer_[size_++] = value;
+    expected_size_ = value + kFrameOverhead;
+    checksum_offset_ = value + 2u;
+    checksum_.Update(value);
+    state_ = StateBody;
+    return false;
+
+  case StateBody:
+    if (escape_) {
+      escape_ = false;
+      if (value == kFrameEscape)
+        return false;
+      if (value == kFrameHeader) {
+        HAIER_LOGW("EspHaier Parser", "Header inside a frame, resyncing");
+        // The first 0xFF of the new header was stored in the frame
+        Resync(size_ - 1);
+        StartFrame();
+        return false;
+      }
+      // A 0xFF that was not escaped, keep going and let the checksum decide
+    }
+    return FeedFrame(value);
+  }
+
+  return false;
+}
+
+bool FrameParser::FeedFrame(byte value) {
+  if (size_ < checksum_offset_)
+    checksum_.Update(value);
+  buffer_[size_++] = value;
+
+  if (size_ == Offset::OffsetFlags + 1 && (value & FrameFlags::FlagCrc16))
+    expected_size_ += kCrc16Size;
+
+  if (size_ < expected_size_) {
+    escape_ = value == kFrameHeader;
+    return false;
+  }
+
+  // A trailing escape byte is skipped while looking for the next header
+  escape_ = value == kFrameHeader;
+  state_ = StateHeader1;
+  return true;
+}
+
+void FrameParser::Reset() {
+  state_ = StateHeader1;
+  size_ = 0;
+  expected_size_ = 0;
+  escape_ = false;
+}
+
+void FrameParser::Resync(size_t dropped) {
+  resyncs_++;
+  dropped_bytes_ += dropped;
+}
+
+void FrameParser::StartFrame() {
+  buffer_[0] = kFrameHeader;
+  buffer_[1] = kFrameHeader;
+  size_ = 2;
+  escape_ = false;
+  checksum_ = FrameChecksum();
+  state_ = StateLength;
+}
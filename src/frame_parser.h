@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "utility.h"
+
+// Incremental parser for frames coming from the AC. Bytes are fed one at a
+// time, so it never waits for data that has not arrived yet. Frame boundaries
+// are taken from the length byte (the same one crc_offset() reads):
+//   FF FF | length | flags | ... | checksum | [crc16 if flags has 0x40]
+// The 0x55 escape after 0xFF is removed (see encodeFrame()), and FF FF in the
+// middle of a frame restarts parsing on the new header.
+class FrameParser {
+public:
+  // Returns true when the byte completes a frame, which can then be read with
+  // data() / size() until the next call.
+  bool Feed(byte value);
+  void Reset();
+
+  const byte *data() const { return buffer_.data(); }
+  size_t size() const { return size_; }
+
+  // Checksums of the last frame, computed while its bytes arrived
+  const FrameChecksum &checksum() const { return checksum_; }
+
+  // Frames abandoned on a bad length or a header inside a frame, and every
+  // byte that did not end up in a frame
+  uint32_t resyncs() const { return resyncs_; }
+  uint32_t dropped_bytes() const { return dropped_bytes_; }
+
+private:
+  enum State {
+    StateHeader1,
+    StateHeader2,
+    StateLength,
+    StateBody,
+  };
+
+  void StartFrame();
+  bool FeedFrame(byte value);
+  void Resync(size_t dropped);
+
+  State state_ = StateHeader1;
+  size_t size_ = 0;
+  size_t expected_size_ = 0;
+  size_t checksum_offset_ = 0;
+  bool escape_ = false;
+  FrameChecksum checksum_;
+  uint32_t resyncs_ = 0;
+  uint32_t dropped_bytes_ = 0;
+  std::array<byte, kMaxFrameSize> buffer_;
+};
@@ -2,18 +2,69 @@
 
 #include "esphome.h"
 
+#include "task_log.h"
 #include "utility.h"
 
-using esphome::esp_log_printf_;
+Initialization::Initialization(Stream &uart) : uart_(uart) {}
 
-void Initialization::Initialize() {
-  Send(initialization_1);
-  Send(initialization_2);
+void Initialization::Start() {
+  state_ = StateInitialization1;
+  sent_ = false;
+  retries_ = 0;
+  started_at_ = millis();
+}
+
+void Initialization::Loop() {
+  if (state_ == StateIdle || state_ == StateDone)
+    return;
+
+  const uint32_t now = millis();
+  if (sent_ && now - sent_at_ < kInitializationTimeoutInMilisec)
+    return;
+
+  if (sent_ && ++retries_ > kInitializationMaxRetries) {
+    HAIER_LOGW("EspHaier Initialization",
+               "No answer from the AC, polling anyway");
+    Finish();
+    return;
+  }
+
+  Send(state_ == StateInitialization1 ? initialization_1 : initialization_2);
+  sent_ = true;
+  sent_at_ = now;
+}
+
+void Initialization::OnFrame(byte command) {
+  if (!sent_)
+    return;
+
+  if ((state_ == StateInitialization1 &&
+       command == initialization_1[Offset::OffsetCommand] + 1) ||
+      (state_ == StateInitialization2 &&
+       command == initialization_2[Offset::OffsetCommand] + 1)) {
+    HAIER_LOGD("EspHaier Initialization", "Answer 0x%X received", command);
+    retries_ = 0;
+    sent_ = false;
+    if (state_ == StateInitialization1)
+      state_ = StateInitialization2;
+    else
+      Finish();
+  }
+}
+
+void Initialization::OnStatus() {
+  if (state_ != StateIdle && state_ != StateDone)
+    Finish();
 }
 
 void Initialization::Send(const InitializationType &initialization) {
-  ::delay(1000);
-  Serial.write(initialization.data(), initialization.size());
-  auto raw = getHex(initialization);
-  ESP_LOGD("EspHaier Initialization", "initialization: %s ", raw.c_str());
-}
\ No newline at end of file
+  writeFrame(uart_, initialization.data(), initialization.size());
+  HAIER_LOGD("EspHaier Initialization", "initialization: %s ",
+             HexDump(initialization).c_str());
+}
+
+void Initialization::Finish() {
+  state_ = StateDone;
+  HAIER_LOGD("EspHaier Initialization", "Done in %u ms",
+             (unsigned)(millis() - started_at_));
+}
@@ -1,14 +1,42 @@
 #pragma once
 
+#include "esphome.h"
+
 #include "constants.h"
 
+// Handshake sent to the AC at startup, driven from loop() so it never blocks.
+// Each frame is resent until the AC answers it (with the request command + 1)
+// or the retries run out; a status frame from the AC also ends it since the
+// AC is obviously up.
 class Initialization {
 public:
-  void Initialize();
+  explicit Initialization(Stream &uart);
+
+  void Start();
+  void Loop();
+  void OnFrame(byte command);
+  void OnStatus();
+
+  bool IsDone() const { return state_ == StateDone; }
 
 private:
+  enum State {
+    StateIdle,
+    StateInitialization1,
+    StateInitialization2,
+    StateDone,
+  };
+
   void Send(const InitializationType &initialization);
+  void Finish();
 
+  Stream &uart_;
   InitializationType initialization_1 = GetInitialization1();
   InitializationType initialization_2 = GetInitialization2();
-};
\ No newline at end of file
+
+  State state_ = StateIdle;
+  bool sent_ = false;
+  uint32_t sent_at_ = 0;
+  uint32_t started_at_ = 0;
+  uint8_t retries_ = 0;
+};
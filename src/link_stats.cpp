@@ -0,0 +1,44 @@
+#include "link_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "esphome.h"
+
+#include "task_log.h"
+
+void Histogram::Record(uint32_t value) {
+  const auto bound = std::lower_bound(kBounds.begin(), kBounds.end(), value);
+  buckets_[bound - kBounds.begin()]++;
+  count_++;
+  sum_ += value;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+void Histogram::Log(const char *name) const {
+  // 10 buckets of up to 10 digits
+  char buckets[kBuckets * 11 + 1] = "";
+  size_t used = 0;
+  for (uint32_t bucket : buckets_)
+    used += std::snprintf(buckets + used, sizeof(buckets) - used, " %u",
+                          (unsigned)bucket);
+
+  HAIER_LOGI("EspHaier Stats", "%s: n=%u min=%u mean=%u max=%u |%s", name,
+             (unsigned)count(), (unsigned)min(), (unsigned)mean(),
+             (unsigned)max(), buckets);
+}
+
+void LinkStats::Log() const {
+  HAIER_LOGI("EspHaier Stats",
+             "polls=%u unanswered=%u statuses=%u checksum_failures=%u "
+             "temperature_rejects=%u resyncs=%u dropped_bytes=%u "
+             "rx_overflows=%u",
+             (unsigned)polls, (unsigned)unanswered_polls, (unsigned)statuses,
+             (unsigned)checksum_failures, (unsigned)temperature_rejects,
+             (unsigned)resyncs, (unsigned)dropped_bytes,
+             (unsigned)rx_overflows);
+  poll_rtt.Log("poll_rtt_ms");
+  control_latency.Log("control_latency_ms");
+  loop_time.Log("loop_time_us");
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+
+#include "esphome.h"
+
+// Fixed bucket histogram, the bounds suit both milliseconds (round trips) and
+// microseconds (loop time). Values above the last bound go to an extra bucket.
+class Histogram {
+public:
+  static constexpr std::array<uint32_t, 9> kBounds = {
+      10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+  static constexpr size_t kBuckets = kBounds.size() + 1;
+
+  void Record(uint32_t value);
+
+  uint32_t count() const { return count_; }
+  uint32_t min() const { return count_ ? min_ : 0; }
+  uint32_t max() const { return max_; }
+  uint32_t mean() const { return count_ ? sum_ / count_ : 0; }
+  uint32_t bucket(size_t index) const { return buckets_[index]; }
+
+  // Compact one line form: "n=12 min=30 mean=41 max=80 | 0 0 3 9 0 ..."
+  void Log(const char *name) const;
+
+private:
+  std::array<uint32_t, kBuckets> buckets_ = {};
+  uint32_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint32_t min_ = UINT32_MAX;
+  uint32_t max_ = 0;
+};
+
+// Health of the serial link to one unit
+struct LinkStats {
+  // From Status::SendPoll() to the next valid status, in ms
+  Histogram poll_rtt;
+  // From Control::Send() to the status confirming the frame, in ms
+  Histogram control_latency;
+  // Time spent in Haier::loop(), in us
+  Histogram loop_time;
+
+  uint32_t polls = 0;
+  uint32_t unanswered_polls = 0;
+  uint32_t statuses = 0;
+  uint32_t checksum_failures = 0;
+  uint32_t temperature_rejects = 0;
+  // Frames abandoned by the parser and the bytes thrown away with them
+  uint32_t resyncs = 0;
+  uint32_t dropped_bytes = 0;
+  // Bytes lost because the receive buffer was full
+  uint32_t rx_overflows = 0;
+
+  void Log() const;
+};
@@ -0,0 +1,54 @@
+#include "link_supervisor.h"
+
+#include <algorithm>
+
+#include "esphome.h"
+
+#include "task_log.h"
+
+bool LinkSupervisor::ShouldPoll(bool scheduled) const {
+  return state_ == StateBackoff ? attempt_poll_ : scheduled;
+}
+
+bool LinkSupervisor::ShouldReinitialize(uint32_t now) const {
+  return state_ == StateBackoff && now - attempt_at_ >= backoff_;
+}
+
+void LinkSupervisor::OnPoll(uint32_t now) {
+  attempt_poll_ = false;
+  if (!outstanding_) {
+    outstanding_ = true;
+    return;
+  }
+
+  if (misses_ < 0xFF)
+    misses_++;
+  if (state_ == StateHealthy && misses_ >= kLinkMissingPolls) {
+    HAIER_LOGW("EspHaier Link", "%d polls not answered", misses_);
+    state_ = StateMissing;
+  } else if (state_ == StateMissing && misses_ >= kLinkLostPolls) {
+    HAIER_LOGW("EspHaier Link", "AC not answering, retrying in %u s",
+               (unsigned)(backoff_ / 1000));
+    state_ = StateBackoff;
+    attempt_at_ = now;
+  }
+}
+
+void LinkSupervisor::OnReinitialize(uint32_t now) {
+  attempt_at_ = now;
+  attempt_poll_ = true;
+  backoff_ = std::min(backoff_ * 2, kLinkBackoffMaxInMilisec);
+  HAIER_LOGD("EspHaier Link", "Reinitializing, next attempt in %u s",
+             (unsigned)(backoff_ / 1000));
+}
+
+void LinkSupervisor::OnStatus() {
+  if (state_ != StateHealthy)
+    HAIER_LOGI("EspHaier Link", "AC answering again");
+
+  state_ = StateHealthy;
+  answered_ = true;
+  outstanding_ = false;
+  misses_ = 0;
+  backoff_ = kLinkBackoffMinInMilisec;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "esphome.h"
+
+#include "constants.h"
+
+// Watches whether the AC answers the polls and decides what to do when it
+// does not:
+//   healthy   statuses come back
+//   missing   kLinkMissingPolls polls in a row were not answered, polling
+//             goes on as scheduled
+//   backoff   kLinkLostPolls polls were not answered: the link is reported
+//             down, scheduled polls stop, and the handshake is rerun
+//             followed by a single poll, at an interval doubling from
+//             kLinkBackoffMinInMilisec to kLinkBackoffMaxInMilisec
+// Any status brings it back to healthy.
+class LinkSupervisor {
+public:
+  // Whether the poll the PollScheduler wants (or a refresh) is to be sent
+  bool ShouldPoll(bool scheduled) const;
+  // True when the handshake is to be rerun
+  bool ShouldReinitialize(uint32_t now) const;
+  bool IsConnected() const { return answered_ && state_ != StateBackoff; }
+
+  void OnPoll(uint32_t now);
+  void OnReinitialize(uint32_t now);
+  void OnStatus();
+
+private:
+  enum State {
+    StateHealthy,
+    StateMissing,
+    StateBackoff,
+  };
+
+  State state_ = StateHealthy;
+  bool answered_ = false;
+  bool outstanding_ = false;
+  uint8_t misses_ = 0;
+  bool attempt_poll_ = false;
+  uint32_t attempt_at_ = 0;
+  uint32_t backoff_ = kLinkBackoffMinInMilisec;
+};
@@ -0,0 +1,139 @@
+#include "optimistic_state.h"
+
+#include "esphome.h"
+
+#include "fields.h"
+#include "task_log.h"
+
+using esphome::climate::ClimatePreset;
+
+ClimatePreset ClimateState::preset() const {
+  if (fast)
+    return ClimatePreset::CLIMATE_PRESET_BOOST;
+  if (quiet)
+    return ClimatePreset::CLIMATE_PRESET_SLEEP;
+  return ClimatePreset::CLIMATE_PRESET_NONE;
+}
+
+bool OptimisticState::OnRequest(const ControlRequest &request, uint32_t now) {
+  byte fields = 0;
+  if (request.mode) {
+    requested_.mode = published_.mode = *request.mode;
+    fields |= StatusField::FieldMode;
+  }
+  if (request.fan_mode) {
+    requested_.fan_mode = published_.fan_mode = *request.fan_mode;
+    fields |= StatusField::FieldFanMode;
+  }
+  if (request.swing_mode) {
+    requested_.swing_mode = published_.swing_mode = *request.swing_mode;
+    fields |= StatusField::FieldSwingMode;
+  }
+  if (request.target_temperature &&
+      !std::isnan(*request.target_temperature)) {
+    const float target_temperature =
+        Control::SetPoint(*request.target_temperature);
+    requested_.target_temperature = target_temperature;
+    published_.target_temperature = target_temperature;
+    fields |= StatusField::FieldTargetTemperature;
+  }
+  if (request.quiet || request.fast || request.purify) {
+    // Features not in the request keep their published state
+    if (!(pending_fields_ & StatusField::FieldFeatures)) {
+      requested_.quiet = actual_.quiet;
+      requested_.fast = actual_.fast;
+      requested_.purify = actual_.purify;
+    }
+    if (request.quiet)
+      requested_.quiet = request.quiet;
+    if (request.fast)
+      requested_.fast = request.fast;
+    if (request.purify)
+      requested_.purify = request.purify;
+    published_.quiet = *requested_.quiet;
+    published_.fast = *requested_.fast;
+    published_.purify = *requested_.purify;
+    fields |= StatusField::FieldFeatures;
+  }
+  if (fields == 0)
+    return false;
+
+  pending_since_ = now;
+  pending_fields_ |= fields;
+  return true;
+}
+
+void OptimisticState::OnStatus(const StatusSnapshot &snapshot) {
+  actual_ = snapshot;
+
+  byte confirmed = 0;
+  if ((pending_fields_ & StatusField::FieldMode) &&
+      snapshot.mode == *requested_.mode)
+    confirmed |= StatusField::FieldMode;
+  if ((pending_fields_ & StatusField::FieldFanMode) &&
+      snapshot.fan_mode == *requested_.fan_mode)
+    confirmed |= StatusField::FieldFanMode;
+  if ((pending_fields_ & StatusField::FieldSwingMode) &&
+      snapshot.swing_mode == *requested_.swing_mode)
+    confirmed |= StatusField::FieldSwingMode;
+  if ((pending_fields_ & StatusField::FieldTargetTemperature) &&
+      snapshot.target_temperature == *requested_.target_temperature)
+    confirmed |= StatusField::FieldTargetTemperature;
+  if ((pending_fields_ & StatusField::FieldFeatures) &&
+      snapshot.quiet == *requested_.quiet &&
+      snapshot.fast == *requested_.fast &&
+      snapshot.purify == *requested_.purify)
+    confirmed |= StatusField::FieldFeatures;
+  pending_fields_ &= ~confirmed;
+
+  const byte fields = ~pending_fields_;
+  if (fields & StatusField::FieldMode)
+    published_.mode = snapshot.mode;
+  if (fields & StatusField::FieldFanMode)
+    published_.fan_mode = snapshot.fan_mode;
+  if (fields & StatusField::FieldSwingMode)
+    published_.swing_mode = snapshot.swing_mode;
+  if (fields & StatusField::FieldTargetTemperature)
+    published_.target_temperature = snapshot.target_temperature;
+  if (fields & StatusField::FieldFeatures) {
+    published_.quiet = snapshot.quiet;
+    published_.fast = snapshot.fast;
+    published_.purify = snapshot.purify;
+  }
+}
+
+bool OptimisticState::OnResult(ControlResult result) {
+  if (result == ControlResult::ControlRejected)
+    return Rollback("rejected");
+  if (result == ControlResult::ControlExpired)
+    return Rollback("not confirmed");
+  return false;
+}
+
+bool OptimisticState::Loop(uint32_t now) {
+  if (now - pending_since_ < kPendingStateTimeoutInMilisec)
+    return false;
+  return Rollback("timed out");
+}
+
+bool OptimisticState::Rollback(const char *reason) {
+  if (pending_fields_ == 0)
+    return false;
+
+  HAIER_LOGW("EspHaier Control", "Control %s, state rolled back", reason);
+  if (pending_fields_ & StatusField::FieldMode)
+    published_.mode = actual_.mode;
+  if (pending_fields_ & StatusField::FieldFanMode)
+    published_.fan_mode = actual_.fan_mode;
+  if (pending_fields_ & StatusField::FieldSwingMode)
+    published_.swing_mode = actual_.swing_mode;
+  if (pending_fields_ & StatusField::FieldTargetTemperature)
+    published_.target_temperature = actual_.target_temperature;
+  if (pending_fields_ & StatusField::FieldFeatures) {
+    published_.quiet = actual_.quiet;
+    published_.fast = actual_.fast;
+    published_.purify = actual_.purify;
+  }
+  pending_fields_ = 0;
+  return true;
+}
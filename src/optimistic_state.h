@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cmath>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "control.h"
+#include "protocol_engine.h"
+#include "tx_scheduler.h"
+
+// What the climate and the feature switches show
+struct ClimateState {
+  esphome::climate::ClimateMode mode;
+  esphome::climate::ClimateFanMode fan_mode;
+  esphome::climate::ClimateSwingMode swing_mode;
+  float target_temperature;
+  bool quiet;
+  bool fast;
+  bool purify;
+
+  // Fast is boost, quiet is sleep. Purify has no preset, it goes along with
+  // any of them.
+  esphome::climate::ClimatePreset preset() const;
+};
+
+// Publishes a requested state right away instead of after the next poll.
+// Each requested field stays pending until a status shows it, and the pending
+// fields are rolled back to the last status when the AC rejects the control,
+// when it expires, or when no status shows them within
+// kPendingStateTimeoutInMilisec.
+class OptimisticState {
+public:
+  const ClimateState &published() const { return published_; }
+  // Last status from the AC, what a rollback goes back to
+  const StatusSnapshot &actual() const { return actual_; }
+  // StatusField mask of the published fields the AC has not shown yet
+  byte pending() const { return pending_fields_; }
+
+  // A request handed to the engine, false when it sets nothing
+  bool OnRequest(const ControlRequest &request, uint32_t now);
+  // Every status from the AC. Fields it does not show yet keep the requested
+  // value.
+  void OnStatus(const StatusSnapshot &snapshot);
+  // The ones below return true when they rolled the state back
+  bool OnResult(ControlResult result);
+  // Rolls back the fields pending for too long
+  bool Loop(uint32_t now);
+
+private:
+  bool Rollback(const char *reason);
+
+  ClimateState published_ = {
+      esphome::climate::ClimateMode::CLIMATE_MODE_OFF,
+      esphome::climate::ClimateFanMode::CLIMATE_FAN_AUTO,
+      esphome::climate::ClimateSwingMode::CLIMATE_SWING_OFF,
+      NAN,
+      false,
+      false,
+      false};
+  StatusSnapshot actual_ = {};
+  ControlRequest requested_;
+  byte pending_fields_ = 0;
+  uint32_t pending_since_ = 0;
+};
@@ -0,0 +1,34 @@
+#include "poll_scheduler.h"
+
+bool PollScheduler::ShouldPoll(uint32_t now) const {
+  if (!polled_)
+    return true;
+
+  const uint32_t interval = GetInterval(now);
+  return now - last_poll_ >= interval && now - last_status_ >= interval;
+}
+
+uint32_t PollScheduler::GetInterval(uint32_t now) const {
+  if (fast_ && now - control_at_ < fast_duration_)
+    return fast_interval_;
+  if (now - last_change_ >= stable_duration_)
+    return slow_interval_;
+  return interval_;
+}
+
+void PollScheduler::OnPoll(uint32_t now) {
+  polled_ = true;
+  last_poll_ = now;
+}
+
+void PollScheduler::OnControl(uint32_t now) {
+  fast_ = true;
+  control_at_ = now;
+  last_change_ = now;
+}
+
+void PollScheduler::OnStatus(uint32_t now, bool changed) {
+  last_status_ = now;
+  if (changed)
+    last_change_ = now;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "esphome.h"
+
+#include "constants.h"
+
+// Decides when to poll the AC. Polls fast for a while after a control call so
+// the confirmation shows up quickly, slows down once the state has been
+// stable for a while, and skips a poll when a status frame was just received.
+class PollScheduler {
+public:
+  void set_fast_interval(uint32_t fast_interval) {
+    fast_interval_ = fast_interval;
+  }
+  void set_fast_duration(uint32_t fast_duration) {
+    fast_duration_ = fast_duration;
+  }
+  void set_interval(uint32_t interval) { interval_ = interval; }
+  void set_slow_interval(uint32_t slow_interval) {
+    slow_interval_ = slow_interval;
+  }
+  void set_stable_duration(uint32_t stable_duration) {
+    stable_duration_ = stable_duration;
+  }
+
+  bool ShouldPoll(uint32_t now) const;
+  uint32_t GetInterval(uint32_t now) const;
+
+  void OnPoll(uint32_t now);
+  void OnControl(uint32_t now);
+  void OnStatus(uint32_t now, bool changed);
+
+private:
+  uint32_t fast_interval_ = kFastPollingIntervalInMilisec;
+  uint32_t fast_duration_ = kFastPollingDurationInMilisec;
+  uint32_t interval_ = kPollingIntervalInMilisec;
+  uint32_t slow_interval_ = kSlowPollingIntervalInMilisec;
+  uint32_t stable_duration_ = kStableDurationInMilisec;
+
+  bool polled_ = false;
+  uint32_t last_poll_ = 0;
+  uint32_t last_status_ = 0;
+  uint32_t last_change_ = 0;
+  uint32_t control_at_ = 0;
+  bool fast_ = false;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "esphome.h"
+
+#include "constants.h"
+
+// A model profile describes one unit / firmware: where the values live in the
+// frames, which modes and swing positions it has and the valid ranges. All
+// members are constexpr so the decoders are built for the selected profile at
+// compile time.
+
+// Haier Flexis White Matt, firmware R_1.0.00/e_2.5.14
+struct FlexisProfile {
+  // Frame layout, shared by the status and the control frame
+  static constexpr byte kOffsetSetTemperature = Offset::OffsetSetTemperature;
+  static constexpr byte kOffsetVerticalSwing = Offset::OffsetVerticalSwing;
+  static constexpr byte kOffsetMode = Offset::OffsetMode;
+  static constexpr byte kOffsetStatusData = Offset::OffsetStatusData;
+  static constexpr byte kOffsetHorizontalSwing = Offset::OffsetHorizontalSwing;
+  static constexpr byte kOffsetCurrentTemperature =
+      Offset::OffsetCurrentTemperature;
+  static constexpr byte kOffsetLock = Offset::OffsetLock;
+  static constexpr byte kOffsetFresh = Offset::OffsetFresh;
+
+  // Valid ranges, in degrees
+  static constexpr float kMinSetTemperature =
+      TempConstraints::MinSetTemperature;
+  static constexpr float kMaxSetTemperature =
+      TempConstraints::MaxSetTemperature;
+  static constexpr float kMinValidInternalTemp =
+      TempConstraints::MinValidInternalTemp;
+  static constexpr float kMaxValidInternalTemp =
+      TempConstraints::MaxValidInternalTemp;
+
+  // Swing positions used for the "off" and "auto" swing modes
+  static constexpr byte kHorizontalSwingOff = HorizontalSwingCenter;
+  static constexpr byte kHorizontalSwingAuto = HorizontalSwingAuto;
+  static constexpr byte kVerticalSwingOff = VerticalSwingCenter;
+  static constexpr byte kVerticalSwingAuto = VerticalSwingAuto;
+
+  // Supported modes
+  static constexpr bool kFanOnlyMode = false;
+  static constexpr bool kHorizontalSwing = true;
+};
+
+// Same layout, with the fan only mode exposed
+struct FlexisFanOnlyProfile : FlexisProfile {
+  static constexpr bool kFanOnlyMode = true;
+};
+
+// Selected with a build flag, e.g. -DHAIER_MODEL_PROFILE=FlexisFanOnlyProfile
+#ifndef HAIER_MODEL_PROFILE
+#define HAIER_MODEL_PROFILE FlexisProfile
+#endif
+
+using ModelProfile = HAIER_MODEL_PROFILE;
+
+static_assert(ModelProfile::kMinSetTemperature <
+                  ModelProfile::kMaxSetTemperature,
+              "Invalid set temperature range");
+static_assert(ModelProfile::kMinValidInternalTemp <
+                  ModelProfile::kMaxValidInternalTemp,
+              "Invalid internal temperature range");
@@ -0,0 +1,174 @@
+#include "protocol_engine.h"
+
+#include <algorithm>
+
+#include "esphome.h"
+
+#include "task_log.h"
+
+using esphome::climate::ClimateCall;
+
+ProtocolEngine::ProtocolEngine(Stream &uart)
+    : rx_buffer_(uart), status_(rx_buffer_), initialization_(uart),
+      tx_scheduler_(uart, status_, UnitScheduler::shared(), status_.stats()) {
+  RegisterFrameHandlers();
+  // Dropped if the ESPHome loop falls behind, its pending state then expires
+  tx_scheduler_.set_result_handler(
+      [this](ControlResult result) { results_.Push(result); });
+}
+
+void ProtocolEngine::RegisterFrameHandlers() {
+  FrameDispatcher &dispatcher = status_.dispatcher();
+
+  auto on_initialization = [this](const FrameView &frame) {
+    initialization_.OnFrame(frame.command());
+  };
+  dispatcher.Register(CommandType::CommandDeviceVersionResponse,
+                      on_initialization);
+  dispatcher.Register(CommandType::CommandDeviceIdResponse, on_initialization);
+
+  dispatcher.Register(CommandType::CommandConfirm,
+                      [this](const FrameView &) { tx_scheduler_.OnAck(); });
+  dispatcher.Register(CommandType::CommandInvalid, [this](const FrameView &) {
+    tx_scheduler_.OnRejected();
+  });
+}
+
+void ProtocolEngine::Start() { initialization_.Start(); }
+
+void ProtocolEngine::Loop() {
+  const uint32_t start = micros();
+
+#ifndef HAIER_RX_CALLBACK
+  rx_buffer_.Fill();
+#endif
+  HandleRequests();
+
+  if (link_supervisor_.ShouldReinitialize(millis())) {
+    link_supervisor_.OnReinitialize(millis());
+    initialization_.Start();
+  }
+  initialization_.Loop();
+  if (initialization_.IsDone()) {
+    tx_scheduler_.Loop();
+    Poll();
+  }
+
+  if (status_.OnPendingData())
+    HandleStatus();
+
+  connected_ = link_supervisor_.IsConnected();
+
+  if (history_dump_requested_.exchange(false) && history_dump_ == nullptr) {
+    history_dump_.reset(new StatusHistory(status_.history()));
+    history_dump_line_ = 0;
+  }
+  if (history_dump_ != nullptr)
+    DumpHistory();
+
+  LinkStats &stats = status_.stats();
+  stats.loop_time.Record(micros() - start);
+  if (millis() - last_stats_ >= kStatsPublishIntervalInMilisec) {
+    last_stats_ = millis();
+    stats.rx_overflows = rx_buffer_.overflows();
+    stats_.Push(stats);
+  }
+}
+
+void ProtocolEngine::DumpHistory() {
+  // More lines than the task log holds, only those it has room for now
+  const size_t count = std::min(kHistoryDumpLinesPerLoop, TaskLog::Room());
+  const bool done = history_dump_->Dump(
+      [](const char *line) { HAIER_LOGI("EspHaier History", "%s", line); },
+      history_dump_line_, count);
+  history_dump_line_ += count;
+  if (done)
+    history_dump_.reset();
+}
+
+bool ProtocolEngine::Submit(const ClimateCall &call) {
+  return Submit(ControlRequest::FromCall(call));
+}
+
+bool ProtocolEngine::Submit(const ControlRequest &request) {
+  return requests_.Push(request);
+}
+
+bool ProtocolEngine::PopStatus(StatusSnapshot &snapshot) {
+  return snapshots_.Pop(snapshot);
+}
+
+bool ProtocolEngine::PopStats(LinkStats &stats) { return stats_.Pop(stats); }
+
+bool ProtocolEngine::PopPersisted(PersistedStatus &persisted) {
+  return persisted_.Pop(persisted);
+}
+
+bool ProtocolEngine::Restore(const PersistedStatus &persisted) {
+  if (!status_.Restore(persisted))
+    return false;
+  PushSnapshot();
+  return true;
+}
+
+bool ProtocolEngine::PopResult(ControlResult &result) {
+  return results_.Pop(result);
+}
+
+void ProtocolEngine::HandleRequests() {
+  ControlRequest request;
+  while (requests_.Pop(request)) {
+    tx_scheduler_.Queue(request);
+    poll_scheduler_.OnControl(millis());
+  }
+}
+
+void ProtocolEngine::HandleStatus() {
+  status_.LogStatus();
+  initialization_.OnStatus();
+  tx_scheduler_.OnStatus();
+  link_supervisor_.OnStatus();
+  poll_scheduler_.OnStatus(rx_buffer_.frame_time(),
+                           status_.GetChangedFields() != 0);
+
+  PushSnapshot();
+
+  // The current temperature alone is not worth a flash write
+  unpersisted_ |= (status_.GetChangedFields() & ~FieldCurrentTemperature) != 0;
+  if (unpersisted_ && persisted_.Push(status_.Persist()))
+    unpersisted_ = false;
+}
+
+void ProtocolEngine::PushSnapshot() {
+  unsent_fields_ |= status_.GetChangedFields();
+  const StatusSnapshot snapshot = {
+      status_.GetMode(),
+      status_.GetFanMode(),
+      status_.GetSwingMode(),
+      status_.GetCurrentTemperature(),
+      status_.GetTargetTemperature(),
+      status_.GetQuietModeStatus(),
+      status_.GetFastModeStatus(),
+      status_.GetPurifyStatus(),
+      status_.GetLockStatus(),
+      status_.GetFreshStatus(),
+      unsent_fields_,
+  };
+  // A full queue is caught up by the next status, which is newer anyway
+  if (snapshots_.Push(snapshot))
+    unsent_fields_ = 0;
+}
+
+void ProtocolEngine::Poll() {
+  const uint32_t now = millis();
+
+  const bool poll = link_supervisor_.ShouldPoll(
+      poll_scheduler_.ShouldPoll(now) || tx_scheduler_.NeedsRefresh(now));
+  if (!poll || !tx_scheduler_.CanTransmit(now))
+    return;
+
+  status_.SendPoll();
+  poll_scheduler_.OnPoll(now);
+  link_supervisor_.OnPoll(now);
+  tx_scheduler_.OnTransmit();
+}
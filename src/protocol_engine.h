@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "initialization.h"
+#include "link_stats.h"
+#include "link_supervisor.h"
+#include "poll_scheduler.h"
+#include "rx_buffer.h"
+#include "spsc_ring.h"
+#include "status.h"
+#include "tx_scheduler.h"
+
+// Decoded state handed from the protocol engine to the ESPHome loop
+struct StatusSnapshot {
+  esphome::climate::ClimateMode mode;
+  esphome::climate::ClimateFanMode fan_mode;
+  esphome::climate::ClimateSwingMode swing_mode;
+  float current_temperature;
+  float target_temperature;
+  bool quiet;
+  bool fast;
+  bool purify;
+  bool lock;
+  bool fresh;
+  // StatusField mask of what changed since the previous snapshot
+  byte changed_fields;
+};
+
+// Everything that talks to the AC: receiving and decoding, the handshake,
+// polling and sending control frames. Loop() can run on its own task; the
+// ESPHome side only talks to it through the SPSC queues below, Submit() and
+// the Pop*() / Request*() functions being the only calls allowed from the
+// other thread.
+class ProtocolEngine {
+public:
+  explicit ProtocolEngine(Stream &uart);
+
+  // Engine side
+  void Start();
+  void Loop();
+
+  // ESPHome side, false when the queue is full / empty
+  bool Submit(const esphome::climate::ClimateCall &call);
+  bool Submit(const ControlRequest &request);
+  bool PopStatus(StatusSnapshot &snapshot);
+  // Copy of the link stats, every kStatsPublishIntervalInMilisec
+  bool PopStats(LinkStats &stats);
+  // Outcome of every control frame, in order
+  bool PopResult(ControlResult &result);
+  // State worth persisting, when something else than the current temperature
+  // changed
+  bool PopPersisted(PersistedStatus &persisted);
+  // False while the AC does not answer, see LinkSupervisor
+  bool IsConnected() const { return connected_; }
+  // The status history is logged from the engine over its next loops
+  void RequestHistoryDump() { history_dump_requested_ = true; }
+
+  // Only to be used before Start()
+  PollScheduler &poll_scheduler() { return poll_scheduler_; }
+  // Hands the restored state over as the first snapshot, false when it is
+  // not valid
+  bool Restore(const PersistedStatus &persisted);
+  RxBuffer &rx_buffer() { return rx_buffer_; }
+
+private:
+  void RegisterFrameHandlers();
+  void HandleRequests();
+  void HandleStatus();
+  void PushSnapshot();
+  void Poll();
+  void DumpHistory();
+
+  RxBuffer rx_buffer_;
+  Status status_;
+  Initialization initialization_;
+  TxScheduler tx_scheduler_;
+  PollScheduler poll_scheduler_;
+  LinkSupervisor link_supervisor_;
+
+  SpscRing<ControlRequest, kControlQueueSize> requests_;
+  SpscRing<StatusSnapshot, kStatusQueueSize> snapshots_;
+  SpscRing<LinkStats, 2> stats_;
+  SpscRing<ControlResult, kControlQueueSize> results_;
+  SpscRing<PersistedStatus, 2> persisted_;
+  // Changes not handed over yet because the snapshot queue was full
+  byte unsent_fields_ = 0;
+  // Same for the persisted state
+  bool unpersisted_ = false;
+  uint32_t last_stats_ = 0;
+  std::atomic<bool> history_dump_requested_{false};
+  // Copy being dumped, statuses keep changing the history meanwhile
+  std::unique_ptr<StatusHistory> history_dump_;
+  size_t history_dump_line_ = 0;
+  std::atomic<bool> connected_{false};
+};
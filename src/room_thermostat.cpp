@@ -0,0 +1,44 @@
+#include "room_thermostat.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "esphome.h"
+
+#include "control.h"
+
+float RoomThermostat::Update(float target, float room, uint32_t now) {
+  // A new target is followed right away
+  if (target != target_) {
+    target_ = target;
+    set_point_ = NAN;
+  }
+  const float error = target - room;
+
+  if (started_) {
+    const float minutes = (now - last_update_) / 60000.0f;
+    integral_ += kThermostatIntegralGainPerMinute * error * minutes;
+    integral_ = std::min(std::max(integral_, -kThermostatMaxOffset),
+                         kThermostatMaxOffset);
+  }
+  started_ = true;
+  last_update_ = now;
+
+  const float offset =
+      std::min(std::max(kThermostatGain * error + integral_,
+                        -kThermostatMaxOffset),
+               kThermostatMaxOffset);
+  // Whole degrees only: the set point stays put until the wanted one is past
+  // the rounding boundary by the hysteresis, instead of flipping every update
+  const float wanted = target + offset;
+  if (std::isnan(set_point_) ||
+      std::fabs(wanted - set_point_) >= 0.5f + kThermostatHysteresis)
+    set_point_ = Control::SetPoint(std::round(wanted));
+  return set_point_;
+}
+
+void RoomThermostat::Reset() {
+  started_ = false;
+  set_point_ = NAN;
+  integral_ = 0.0f;
+}
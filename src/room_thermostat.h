@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cmath>
+
+#include "esphome.h"
+
+#include "constants.h"
+
+// Regulates the room temperature measured by an external sensor instead of
+// the AC return air, which reads off by a few degrees depending on where the
+// unit hangs. A PI loop on the room error moves the AC set point around the
+// user's target, by at most kThermostatMaxOffset either way; the integral
+// takes out the steady bias between the room and the return air. The set
+// point only moves past kThermostatHysteresis, to keep control frames rare.
+class RoomThermostat {
+public:
+  // AC set point for the target, in whole degrees within the profile range
+  float Update(float target, float room, uint32_t now);
+  // Starts over, e.g. when the mode changes or the sensor goes quiet
+  void Reset();
+
+private:
+  bool started_ = false;
+  uint32_t last_update_ = 0;
+  float integral_ = 0.0f;
+  float target_ = NAN;
+  float set_point_ = NAN;
+};
@@ -0,0 +1,51 @@
+#include "rx_buffer.h"
+
+#include "esphome.h"
+
+void RxBuffer::Fill() {
+  while (uart_.available() > 0) {
+    const byte value = uart_.read();
+
+    if (!bytes_.Push(value)) {
+      overflows_.fetch_add(1, std::memory_order_relaxed);
+      previous_header_ = false;
+      continue;
+    }
+
+    // Escaped data is FF 55, so FF FF can only be a header. A full boundary
+    // queue only costs the timestamp of that frame.
+    if (previous_header_ && value == kFrameHeader)
+      boundaries_.Push({written_ - 1, millis()});
+    previous_header_ = !previous_header_ && value == kFrameHeader;
+    written_++;
+  }
+}
+
+int RxBuffer::available() { return bytes_.size(); }
+
+int RxBuffer::read() {
+  byte value;
+  if (!bytes_.Pop(value))
+    return -1;
+
+  // The boundary can be queued after its first byte was already read
+  Boundary boundary;
+  while (boundaries_.Front() != nullptr &&
+         static_cast<int32_t>(boundaries_.Front()->position - read_) <= 0) {
+    boundaries_.Pop(boundary);
+    frame_time_ = boundary.time;
+  }
+  read_++;
+  return value;
+}
+
+int RxBuffer::peek() {
+  const byte *front = bytes_.Front();
+  return front != nullptr ? *front : -1;
+}
+
+size_t RxBuffer::write(uint8_t value) { return uart_.write(value); }
+
+size_t RxBuffer::write(const uint8_t *buffer, size_t size) {
+  return uart_.write(buffer, size);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "spsc_ring.h"
+
+// The ESP32 core calls back from its UART event task when bytes arrive
+// (HardwareSerial::onReceive, from 2.0.3 on), elsewhere the buffer is filled
+// from the protocol loop
+#if defined(ARDUINO_ARCH_ESP32) && defined(ESP_ARDUINO_VERSION_VAL)
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(2, 0, 3)
+#define HAIER_RX_CALLBACK
+#endif
+#endif
+
+// Receive side of a UART, decoupled from loop(). Fill() is the producer: it
+// moves the bytes out of the driver as soon as they arrive (from the UART
+// receive callback where the core has one, from loop() otherwise) and notes
+// when each frame header was seen. The protocol code is the consumer and
+// reads through the Stream interface; writes go straight to the UART.
+class RxBuffer : public Stream {
+public:
+  explicit RxBuffer(Stream &uart) : uart_(uart) {}
+
+  // Producer side
+  void Fill();
+
+  // Stream overrides, consumer side
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  // Arrival time of the header of the frame being read
+  uint32_t frame_time() const { return frame_time_; }
+  // Bytes lost because the buffer was full
+  uint32_t overflows() const {
+    return overflows_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Boundary {
+    uint32_t position;
+    uint32_t time;
+  };
+
+  Stream &uart_;
+  SpscRing<byte, kRxBufferSize> bytes_;
+  SpscRing<Boundary, kRxBoundaries> boundaries_;
+
+  // Producer
+  uint32_t written_ = 0;
+  bool previous_header_ = false;
+  std::atomic<uint32_t> overflows_{0};
+
+  // Consumer
+  uint32_t read_ = 0;
+  uint32_t frame_time_ = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed size lock-free queue for exactly one producer and one consumer, e.g.
+// a UART driver callback and loop(). Each side only writes its own index, the
+// other one is read with acquire ordering so the element written before the
+// index is visible.
+template <typename T, size_t Size> class SpscRing {
+  static_assert(Size > 1 && (Size & (Size - 1)) == 0,
+                "Size must be a power of two");
+
+public:
+  // Producer side, false when full
+  bool Push(const T &value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Size)
+      return false;
+
+    items_[head & (Size - 1)] = value;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, nullptr when empty
+  const T *Front() const {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail)
+      return nullptr;
+    return &items_[tail & (Size - 1)];
+  }
+
+  bool Pop(T &value) {
+    const T *front = Front();
+    if (front == nullptr)
+      return false;
+
+    value = *front;
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+    return true;
+  }
+
+  // Never less than what the consumer can pop: the other side's index may be
+  // stale, which only makes it look fuller to the producer
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+  static constexpr size_t capacity() { return Size; }
+
+private:
+  std::array<T, Size> items_;
+  // Free running, wrap around together with size_t
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
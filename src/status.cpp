@@ -1,33 +1,42 @@
 #include "status.h"
 
+#include <algorithm>
+
 #include "esphome.h"
 
 #include "constants.h"
+#include "fields.h"
+#include "task_log.h"
 #include "utility.h"
 
-using esphome::esp_log_printf_;
 using esphome::climate::ClimateMode;
 using esphome::climate::ClimateFanMode;
 using esphome::climate::ClimateSwingMode;
 
+Status::Status(Stream &uart) : uart_(uart) {
+  dispatcher_.Register(
+      CommandType::CommandResponsePoll,
+      [this](const FrameView &frame) { OnStatusFrame(frame); });
+}
+
 byte Status::GetHvacModeStatus() const {
-  return status_[Offset::OffsetMode] & AcMode::ModeMask;
+  return fields::HvacMode::Get(status_);
 }
 
 byte Status::GetTemperatureSetpointStatus() const {
-  return status_[Offset::OffsetSetTemperature];
+  return fields::SetTemperature::Get(status_);
 }
 
 byte Status::GetFanSpeedStatus() const {
-  return status_[Offset::OffsetMode] & FanMode::FanMask;
+  return fields::FanSpeed::Get(status_);
 }
 
 byte Status::GetHorizontalSwingStatus() const {
-  return status_[Offset::OffsetHorizontalSwing];
+  return fields::HorizontalSwing::Get(status_);
 }
 
 byte Status::GetVerticalSwingStatus() const {
-  return status_[Offset::OffsetVerticalSwing];
+  return fields::VerticalSwing::Get(status_);
 }
 
 byte Status::GetClimateModeFanSpeed() const { return climate_mode_fan_speed_; }
@@ -39,19 +48,27 @@ byte Status::GetFanModeFanSpeed() const { return fan_mode_fan_speed_; }
 byte Status::GetFanModeSetpoint() const { return fan_mode_setpoint_; }
 
 bool Status::GetPurifyStatus() const {
-  return GetStatusDataField(DataField::DataFieldPurify);
+  return fields::Purify::Get(status_);
 }
 
 bool Status::GetPowerStatus() const {
-  return GetStatusDataField(DataField::DataFieldPower);
+  return fields::Power::Get(status_);
 }
 
 bool Status::GetQuietModeStatus() const {
-  return GetStatusDataField(DataField::DataFieldQuiet);
+  return fields::Quiet::Get(status_);
 }
 
 bool Status::GetFastModeStatus() const {
-  return GetStatusDataField(DataField::DataFieldFanMax);
+  return fields::FanMax::Get(status_);
+}
+
+bool Status::GetLockStatus() const {
+  return fields::Lock::Get(status_) != 0;
+}
+
+bool Status::GetFreshStatus() const {
+  return fields::Fresh::Get(status_);
 }
 
 ClimateMode Status::GetMode() const {
@@ -100,14 +117,17 @@ ClimateFanMode Status::GetFanMode() const {
 ClimateSwingMode Status::GetSwingMode() const {
   if (!GetPowerStatus())
     return ClimateSwingMode::CLIMATE_SWING_OFF;
-  if ((GetHorizontalSwingStatus() ==
-       HorizontalSwingMode::HorizontalSwingAuto) &&
-      (GetVerticalSwingStatus() == VerticalSwingMode::VerticalSwingAuto)) {
+
+  const bool horizontal =
+      GetHorizontalSwingStatus() == ModelProfile::kHorizontalSwingAuto;
+  const bool vertical =
+      GetVerticalSwingStatus() == ModelProfile::kVerticalSwingAuto;
+
+  if (horizontal && vertical) {
     return ClimateSwingMode::CLIMATE_SWING_BOTH;
-  } else if (GetHorizontalSwingStatus() ==
-             HorizontalSwingMode::HorizontalSwingAuto) {
+  } else if (horizontal) {
     return ClimateSwingMode::CLIMATE_SWING_HORIZONTAL;
-  } else if (GetVerticalSwingStatus() == VerticalSwingMode::VerticalSwingAuto) {
+  } else if (vertical) {
     return ClimateSwingMode::CLIMATE_SWING_VERTICAL;
   } else {
     return ClimateSwingMode::CLIMATE_SWING_OFF;
@@ -115,73 +135,141 @@ ClimateSwingMode Status::GetSwingMode() const {
 }
 
 float Status::GetCurrentTemperature() const {
-  return status_[Offset::OffsetCurrentTemperature] / 2;
+  return fields::CurrentTemperature::Get(status_) / 2;
 }
 float Status::GetTargetTemperature() const {
-  return status_[Offset::OffsetSetTemperature] + 16;
+  return fields::SetTemperature::Get(status_) + 16;
 }
 
 bool Status::GetFirstStatusReceived() const { return first_status_received_; }
 
+byte Status::GetChangedFields() const { return changed_fields_; }
+
+uint32_t Status::GetStatusTime() const { return status_time_; }
+
+PersistedStatus Status::Persist() const {
+  return {status_, climate_mode_fan_speed_, climate_mode_setpoint_,
+          fan_mode_fan_speed_, fan_mode_setpoint_};
+}
+
+bool Status::Restore(const PersistedStatus &persisted) {
+  if (persisted.status[Offset::OffsetCommand] !=
+          CommandType::CommandResponsePoll ||
+      !ValidateTemperature(persisted.status))
+    return false;
+
+  status_ = persisted.status;
+  climate_mode_fan_speed_ = persisted.climate_mode_fan_speed;
+  climate_mode_setpoint_ = persisted.climate_mode_setpoint;
+  fan_mode_fan_speed_ = persisted.fan_mode_fan_speed;
+  fan_mode_setpoint_ = persisted.fan_mode_setpoint;
+  first_status_received_ = true;
+  changed_fields_ = FieldAll;
+  return true;
+}
+
 void Status::LogStatus() {
-  ESP_LOGD("EspHaier Status", "Readed message ALBA: %s ",
-           getHex(status_).c_str());
+  if (!LogLevelEnabled(ESPHOME_LOG_LEVEL_DEBUG, "EspHaier Status"))
+    return;
+  HAIER_LOGD("EspHaier Status", "Readed message ALBA: %s ",
+             HexDump(status_).c_str());
   LogChangedBytes();
 }
 
 bool Status::OnPendingData() {
-  StatusMessageType data = {{255, 255}};
-  if (Serial.available() == 0 || Serial.read() != 255 || Serial.read() != 255)
-    return false;
+  status_received_ = false;
 
-  Serial.readBytes(data.data() + 2, data.size() - 2);
+  while (!status_received_ && uart_.available() > 0) {
+    if (!parser_.Feed(uart_.read()))
+      continue;
 
-  if (data[Offset::OffsetCommand] != CommandType::CommandResponsePoll) {
-    ESP_LOGD("EspHaier Status", "Received message is not a status: 0x%X",
-             data[Offset::OffsetCommand]);
-    return false;
+    const FrameView frame(parser_.data(), parser_.size());
+    if (ValidateChecksum(frame))
+      dispatcher_.Dispatch(frame);
   }
+  stats_.resyncs = parser_.resyncs();
+  stats_.dropped_bytes = parser_.dropped_bytes();
 
-  UpdateStatus(data);
-
-  return ValidateChecksum() && ValidateTemperature();
+  return status_received_ && status_valid_;
 }
 
-void Status::SendPoll() const {
-  Serial.write(poll_.data(), poll_.size());
-  ESP_LOGD("EspHaier Status", "POLL: %s ", getHex(poll_).c_str());
+void Status::SendPoll() {
+  if (poll_outstanding_)
+    stats_.unanswered_polls++;
+  poll_outstanding_ = true;
+  poll_sent_at_ = millis();
+  stats_.polls++;
+
+  writeFrame(uart_, poll_.data(), poll_.size());
+  HAIER_LOGD("EspHaier Status", "POLL: %s ", HexDump(poll_).c_str());
 }
 
-bool Status::GetStatusDataField(byte bit) const {
-  return status_[Offset::OffsetStatusData] & (0x01 << bit);
+void Status::OnStatusFrame(const FrameView &frame) {
+  if (frame.size() != status_.size()) {
+    HAIER_LOGD("EspHaier Status", "Unexpected status size %d",
+               (int)frame.size());
+    return;
+  }
+
+  StatusMessageType data;
+  std::copy(frame.data(), frame.data() + frame.size(), data.begin());
+  history_.Record(millis(), data);
+
+  status_received_ = true;
+  // A rejected frame is not taken in, the next one is compared with the last
+  // accepted status
+  status_valid_ = ValidateTemperature(data);
+  if (!status_valid_) {
+    stats_.temperature_rejects++;
+    return;
+  }
+
+  UpdateStatus(data);
+  stats_.statuses++;
+  status_time_ = millis();
+  if (poll_outstanding_) {
+    stats_.poll_rtt.Record(millis() - poll_sent_at_);
+    poll_outstanding_ = false;
+  }
 }
 
-bool Status::ValidateChecksum() const {
-  const byte check = getChecksum(status_);
+bool Status::ValidateChecksum(const FrameView &frame) {
+  // Computed by the parser while the frame was received
+  const FrameChecksum &checksum = parser_.checksum();
+
+  if (checksum.sum != frame.checksum()) {
+    HAIER_LOGW("EspHaier Status", "Invalid checksum (%d vs %d)", checksum.sum,
+               frame.checksum());
+    stats_.checksum_failures++;
+    return false;
+  }
 
-  if (check != status_[crc_offset(status_)]) {
-    ESP_LOGW("EspHaier Status", "Invalid checksum (%d vs %d)", check,
-             status_[crc_offset(status_)]);
+  if (frame.has_crc16() && checksum.crc16 != frame.crc16()) {
+    HAIER_LOGW("EspHaier Status", "Invalid CRC16 (%X vs %X)", checksum.crc16,
+               frame.crc16());
+    stats_.checksum_failures++;
     return false;
   }
   return true;
 }
 
-bool Status::ValidateTemperature() const {
-  const float current_temperature = GetCurrentTemperature();
-  const float target_temperature = GetTargetTemperature();
+bool Status::ValidateTemperature(const StatusMessageType &status) {
+  const float current_temperature = fields::CurrentTemperature::Get(status) / 2;
+  const float target_temperature = fields::SetTemperature::Get(status) + 16;
 
-  if (current_temperature < TempConstraints::MinValidInternalTemp ||
-      current_temperature > TempConstraints::MaxValidInternalTemp ||
-      target_temperature < TempConstraints::MinSetTemperature ||
-      target_temperature > TempConstraints::MaxSetTemperature) {
-    ESP_LOGW("EspHaier Status", "Invalid temperatures");
+  if (current_temperature < ModelProfile::kMinValidInternalTemp ||
+      current_temperature > ModelProfile::kMaxValidInternalTemp ||
+      target_temperature < ModelProfile::kMinSetTemperature ||
+      target_temperature > ModelProfile::kMaxSetTemperature) {
+    HAIER_LOGW("EspHaier Status", "Invalid temperatures");
     return false;
   }
   return true;
 }
 
 void Status::UpdateStatus(const StatusMessageType &data) {
+  changed_fields_ = first_status_received_ ? StatusFields::Diff(status_, data)
+                                           : static_cast<byte>(FieldAll);
   status_ = data;
 
   if (GetHvacModeStatus() == AcMode::ModeFan) {
@@ -197,10 +285,10 @@ void Status::UpdateStatus(const StatusMessageType &data) {
 void Status::LogChangedBytes() {
   PrintDebug();
 
-  for (int i = 0; i < sizeof(status_); i++) {
+  for (size_t i = 0; i < status_.size(); i++) {
     if (status_[i] != previous_status_[i]) {
-      ESP_LOGD("EspHaier Status", "status_ byte %d: 0x%X --> 0x%X ", i,
-               previous_status_[i], status_[i]);
+      HAIER_LOGD("EspHaier Status", "status_ byte %d: 0x%X --> 0x%X ", (int)i,
+                 previous_status_[i], status_[i]);
     }
   }
 
@@ -210,16 +298,17 @@ void Status::LogChangedBytes() {
 void Status::PrintDebug() {
   if (true)
     return;
-  ESP_LOGW("EspHaier Status", "Power Status = 0x%X", GetPowerStatus());
-  ESP_LOGW("EspHaier Status", "HVAC return 0x%X", GetHvacModeStatus());
-  ESP_LOGW("EspHaier Status", "Purify status = 0x%X", GetPurifyStatus());
-  ESP_LOGW("EspHaier Status", "Quiet mode Status = 0x%X", GetQuietModeStatus());
-  ESP_LOGW("EspHaier Status", "Fast mode Status = 0x%X", GetFastModeStatus());
-  ESP_LOGW("EspHaier Status", "Fan speed Status = 0x%X", GetFanSpeedStatus());
-  ESP_LOGW("EspHaier Status", "Horizontal Swing Status = 0x%X",
-           GetHorizontalSwingStatus());
-  ESP_LOGW("EspHaier Status", "Vertical Swing Status = 0x%X",
-           GetVerticalSwingStatus());
-  ESP_LOGW("EspHaier Status", "Set Point Status = 0x%X",
-           GetTemperatureSetpointStatus());
+  HAIER_LOGW("EspHaier Status", "Power Status = 0x%X", GetPowerStatus());
+  HAIER_LOGW("EspHaier Status", "HVAC return 0x%X", GetHvacModeStatus());
+  HAIER_LOGW("EspHaier Status", "Purify status = 0x%X", GetPurifyStatus());
+  HAIER_LOGW("EspHaier Status", "Quiet mode Status = 0x%X",
+             GetQuietModeStatus());
+  HAIER_LOGW("EspHaier Status", "Fast mode Status = 0x%X", GetFastModeStatus());
+  HAIER_LOGW("EspHaier Status", "Fan speed Status = 0x%X", GetFanSpeedStatus());
+  HAIER_LOGW("EspHaier Status", "Horizontal Swing Status = 0x%X",
+             GetHorizontalSwingStatus());
+  HAIER_LOGW("EspHaier Status", "Vertical Swing Status = 0x%X",
+             GetVerticalSwingStatus());
+  HAIER_LOGW("EspHaier Status", "Set Point Status = 0x%X",
+             GetTemperatureSetpointStatus());
 }
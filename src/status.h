@@ -5,9 +5,28 @@
 #include "esphome.h"
 
 #include "constants.h"
+#include "fields.h"
+#include "frame.h"
+#include "frame_dispatcher.h"
+#include "frame_parser.h"
+#include "link_stats.h"
+#include "status_history.h"
 #include "utility.h"
+
+// What is kept in flash across reboots: the last valid status and the fan
+// speed / set point remembered for the other kind of mode
+struct PersistedStatus {
+  StatusMessageType status;
+  byte climate_mode_fan_speed;
+  byte climate_mode_setpoint;
+  byte fan_mode_fan_speed;
+  byte fan_mode_setpoint;
+};
+
 class Status {
 public:
+  explicit Status(Stream &uart);
+
   byte GetHvacModeStatus() const;
   byte GetTemperatureSetpointStatus() const;
 
@@ -22,32 +41,67 @@ public:
   bool GetPowerStatus() const;
   bool GetQuietModeStatus() const;
   bool GetFastModeStatus() const;
+  bool GetLockStatus() const;
+  bool GetFreshStatus() const;
   esphome::climate::ClimateMode GetMode() const;
   esphome::climate::ClimateFanMode GetFanMode() const;
   esphome::climate::ClimateSwingMode GetSwingMode() const;
   float GetCurrentTemperature() const;
   float GetTargetTemperature() const;
   bool GetFirstStatusReceived() const;
+  // StatusField mask of what the last status changed
+  byte GetChangedFields() const;
+  // millis() when the last valid status was received
+  uint32_t GetStatusTime() const;
+
+  // Last received status frame, decoded with the descriptors from fields.h
+  const StatusMessageType &frame() const { return status_; }
+
+  PersistedStatus Persist() const;
+  // Takes a persisted status as if it had been received, false when it does
+  // not hold a valid status
+  bool Restore(const PersistedStatus &persisted);
+
+  // Handlers for the frames that are not a status
+  FrameDispatcher &dispatcher() { return dispatcher_; }
+
+  // Link health, the other parts of the protocol code record into it too
+  const LinkStats &stats() const { return stats_; }
+  LinkStats &stats() { return stats_; }
+  // Every status frame received, valid or not
+  const StatusHistory &history() const { return history_; }
 
   void LogStatus();
+  // Dispatches the received frames, returns true once a valid status was read
   bool OnPendingData();
-  void SendPoll() const;
+  void SendPoll();
 
 private:
-  bool GetStatusDataField(byte bit) const;
-  bool ValidateChecksum() const;
-  bool ValidateTemperature() const;
+  void OnStatusFrame(const FrameView &frame);
+  bool ValidateChecksum(const FrameView &frame);
+  static bool ValidateTemperature(const StatusMessageType &status);
   void UpdateStatus(const StatusMessageType &data);
   void LogChangedBytes();
   void PrintDebug();
 
+  Stream &uart_;
   byte climate_mode_fan_speed_ = FanMode::FanAuto;
   byte climate_mode_setpoint_ = 0x0A;
   byte fan_mode_fan_speed_ = FanMode::FanHigh;
   byte fan_mode_setpoint_ = 0x08;
   bool first_status_received_ = false;
+  byte changed_fields_ = 0;
 
   StatusMessageType status_ = GetStatusMessage();
   StatusMessageType previous_status_ = GetStatusMessage();
   PollMessageType poll_ = GetPollMessage();
+  FrameParser parser_;
+  FrameDispatcher dispatcher_;
+  LinkStats stats_;
+  StatusHistory history_;
+  bool poll_outstanding_ = false;
+  uint32_t poll_sent_at_ = 0;
+  bool status_valid_ = false;
+  uint32_t status_time_ = 0;
+  bool status_received_ = false;
 };
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "status_history.h"
+
+#include "esphome.h"
+
+void StatusHistory::Record(uint32_t time, const Frame &status) {
+  if (!started_) {
+    started_ = true;
+    base_ = last_ = status;
+    base_time_ = last_time_ = time;
+    return;
+  }
+
+  if (status == last_) {
+    repeats_++;
+    return;
+  }
+
+  // Worst case: both varints, then a pair for every changed byte
+  const size_t worst = 2 * 5 + 2 * status.size();
+  while (ring_.size() - used_ < worst && used_ > 0)
+    Evict();
+
+  PushVarint(time - last_time_);
+  PushVarint(repeats_);
+  for (size_t position = 0; position < status.size();) {
+    byte unchanged = 0;
+    while (position < status.size() && status[position] == last_[position]) {
+      unchanged++;
+      position++;
+    }
+    byte changed = 0;
+    while (position + changed < status.size() &&
+           status[position + changed] != last_[position + changed])
+      changed++;
+
+    Push(unchanged);
+    Push(changed);
+    for (; changed > 0; changed--, position++)
+      Push(status[position] ^ last_[position]);
+  }
+
+  last_ = status;
+  last_time_ = time;
+  repeats_ = 0;
+  entries_++;
+}
+
+void StatusHistory::Evict() {
+  const size_t size = Decode([this](size_t offset) { return At(offset); },
+                             used_, base_time_, base_repeats_, base_);
+  // Cannot happen with entries written by Record(), but never loop on it
+  if (size == 0) {
+    used_ = 0;
+    entries_ = 0;
+    base_ = last_;
+    base_time_ = last_time_;
+    base_repeats_ = 0;
+    return;
+  }
+
+  tail_ = (tail_ + size) % ring_.size();
+  used_ -= size;
+  entries_--;
+}
+
+void StatusHistory::Push(byte value) {
+  ring_[(tail_ + used_) % ring_.size()] = value;
+  used_++;
+}
+
+void StatusHistory::PushVarint(uint32_t value) {
+  while (value >= 0x80) {
+    Push((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  Push(value);
+}
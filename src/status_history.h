@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "esphome.h"
+
+#include "constants.h"
+
+// Compressed record of the last status frames received, kept in a fixed
+// kStatusHistorySize byte ring. Each entry is stored against the frame before
+// it:
+//   varint time since the previous entry (ms)
+//   varint identical frames received in between
+//   (unchanged byte count, changed byte count, XOR of the changed bytes)...
+// until the pairs cover the whole frame. The oldest entries are folded into
+// the base frame when the ring is full, so the history always decodes from
+// the base, together with the identical frames received before it.
+// Dump() writes it as text lines, host/history.cpp decodes them.
+class StatusHistory {
+public:
+  using Frame = StatusMessageType;
+
+  void Record(uint32_t time, const Frame &status);
+
+  // Called with one line at a time, without a line break:
+  //   history v2 FRAME_SIZE BASE_TIME BASE_REPEATS ENTRIES REPEATS
+  //   history b HEX...   base frame
+  //   history d HEX...   entries
+  //   history end
+  // BASE_REPEATS are the identical frames received before the base frame
+  // (those of an evicted entry), REPEATS the ones after the last entry.
+  // Only lines first to first + count - 1 are written, true once the last
+  // line was.
+  template <typename Output>
+  bool Dump(Output output, size_t first = 0, size_t count = SIZE_MAX) const;
+
+  size_t entries() const { return entries_; }
+  size_t used() const { return used_; }
+
+  // Applies the entry read through at(0..available) to time / frame. Returns
+  // the size of the entry, 0 when it is truncated or malformed.
+  template <typename ByteAt>
+  static size_t Decode(ByteAt at, size_t available, uint32_t &time,
+                       uint32_t &repeats, Frame &frame);
+
+private:
+  void Evict();
+  void Push(byte value);
+  void PushVarint(uint32_t value);
+  byte At(size_t offset) const {
+    return ring_[(tail_ + offset) % ring_.size()];
+  }
+
+  std::array<byte, kStatusHistorySize> ring_;
+  size_t tail_ = 0;
+  size_t used_ = 0;
+  size_t entries_ = 0;
+
+  bool started_ = false;
+  Frame base_ = {};
+  uint32_t base_time_ = 0;
+  uint32_t base_repeats_ = 0;
+  Frame last_ = {};
+  uint32_t last_time_ = 0;
+  uint32_t repeats_ = 0;
+};
+
+template <typename ByteAt>
+size_t StatusHistory::Decode(ByteAt at, size_t available, uint32_t &time,
+                             uint32_t &repeats, Frame &frame) {
+  size_t size = 0;
+  auto varint = [&](uint32_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 32 && size < available; shift += 7) {
+      const byte part = at(size++);
+      value |= static_cast<uint32_t>(part & 0x7F) << shift;
+      if (!(part & 0x80))
+        return true;
+    }
+    return false;
+  };
+
+  uint32_t delta;
+  if (!varint(delta) || !varint(repeats))
+    return 0;
+
+  Frame decoded = frame;
+  for (size_t position = 0; position < frame.size();) {
+    if (size + 2 > available)
+      return 0;
+    position += at(size++);
+    const byte changed = at(size++);
+    if (position + changed > frame.size() || size + changed > available)
+      return 0;
+    for (byte i = 0; i < changed; i++)
+      decoded[position++] ^= at(size++);
+  }
+
+  time += delta;
+  frame = decoded;
+  return size;
+}
+
+template <typename Output>
+bool StatusHistory::Dump(Output output, size_t first, size_t count) const {
+  size_t number = 0;
+  auto write = [&](const char *line) {
+    if (number >= first && number - first < count)
+      output(line);
+    number++;
+  };
+  char line[10 + 2 * kStatusHistoryLineBytes + 1];
+  auto hex_line = [&](const char *kind, size_t start, size_t end,
+                      auto byte_at) {
+    static const char kDigits[] = "0123456789ABCDEF";
+    for (; start < end; start += kStatusHistoryLineBytes) {
+      size_t length = snprintf(line, sizeof(line), "history %s ", kind);
+      for (size_t i = start; i < std::min(end, start + kStatusHistoryLineBytes);
+           i++) {
+        line[length++] = kDigits[byte_at(i) >> 4];
+        line[length++] = kDigits[byte_at(i) & 0x0F];
+      }
+      line[length] = '\0';
+      write(line);
+    }
+  };
+
+  snprintf(line, sizeof(line), "history v2 %u %u %u %u %u",
+           (unsigned)base_.size(), (unsigned)base_time_,
+           (unsigned)base_repeats_, (unsigned)entries_, (unsigned)repeats_);
+  write(line);
+  hex_line("b", 0, base_.size(), [&](size_t i) { return base_[i]; });
+  hex_line("d", 0, used_, [&](size_t i) { return At(i); });
+  write("history end");
+  return number - std::min(number, first) <= count;
+}
@@ -0,0 +1,18 @@
+#include "status_saver.h"
+
+#include "esphome.h"
+
+#include "fields.h"
+
+void StatusSaver::Update(const PersistedStatus &persisted) {
+  unsaved_ = persisted;
+  save_pending_ = true;
+}
+
+bool StatusSaver::IsSaved() const {
+  return ControlFields::Equal(saved_.status, unsaved_.status) &&
+         saved_.climate_mode_fan_speed == unsaved_.climate_mode_fan_speed &&
+         saved_.climate_mode_setpoint == unsaved_.climate_mode_setpoint &&
+         saved_.fan_mode_fan_speed == unsaved_.fan_mode_fan_speed &&
+         saved_.fan_mode_setpoint == unsaved_.fan_mode_setpoint;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "status.h"
+#include "task_log.h"
+
+// Keeps the flash writes down to one per kStatusSaveIntervalInMilisec: the
+// newest state waits for the interval, and is not written at all when it went
+// back to the saved one meanwhile.
+class StatusSaver {
+public:
+  // State found in flash at boot
+  void set_saved(const PersistedStatus &saved) { saved_ = saved; }
+  const PersistedStatus &saved() const { return saved_; }
+
+  // Newer state to save
+  void Update(const PersistedStatus &persisted);
+  // Calls save(const PersistedStatus &) once the interval ran out, a failed
+  // save (false) is retried after another interval
+  template <typename Save> void Loop(uint32_t now, Save save);
+
+private:
+  bool IsSaved() const;
+
+  PersistedStatus saved_ = {};
+  PersistedStatus unsaved_ = {};
+  bool save_pending_ = false;
+  uint32_t last_save_ = 0;
+};
+
+template <typename Save> void StatusSaver::Loop(uint32_t now, Save save) {
+  if (!save_pending_ || now - last_save_ < kStatusSaveIntervalInMilisec)
+    return;
+
+  save_pending_ = false;
+  // Changes that were undone before the interval ran out
+  if (IsSaved())
+    return;
+
+  last_save_ = now;
+  if (!save(unsaved_)) {
+    HAIER_LOGW("EspHaier State", "Saving the state failed");
+    save_pending_ = true;
+    return;
+  }
+  saved_ = unsaved_;
+}
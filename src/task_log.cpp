@@ -0,0 +1,54 @@
+#include "task_log.h"
+
+#include <cstdio>
+
+#include "esphome.h"
+
+using esphome::esp_log_printf_;
+
+namespace {
+// There is a single task on ESP8266
+#ifdef ARDUINO_ARCH_ESP8266
+TaskLog *attached = nullptr;
+#else
+thread_local TaskLog *attached = nullptr;
+#endif
+} // namespace
+
+void TaskLog::Attach() { attached = this; }
+
+size_t TaskLog::Room() {
+  if (attached == nullptr)
+    return SIZE_MAX;
+  return attached->records_.capacity() - attached->records_.size();
+}
+
+void TaskLog::Printf(int level, const char *tag, int line, const char *format,
+                     ...) {
+  va_list args;
+  va_start(args, format);
+  if (attached == nullptr) {
+    esphome::esp_log_vprintf_(level, tag, line, format, args);
+  } else {
+    Record record;
+    record.level = level;
+    record.line = line;
+    record.tag = tag;
+    vsnprintf(record.message, sizeof(record.message), format, args);
+    if (!attached->records_.Push(record))
+      attached->dropped_++;
+  }
+  va_end(args);
+}
+
+void TaskLog::Flush() {
+  Record record;
+  while (records_.Pop(record))
+    esp_log_printf_(record.level, record.tag, record.line, "%s",
+                    record.message);
+
+  const uint32_t dropped = dropped_.exchange(0);
+  if (dropped > 0)
+    ESP_LOGW("EspHaier Log", "%u lines of the protocol task dropped",
+             (unsigned)dropped);
+}
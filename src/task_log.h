@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "spsc_ring.h"
+
+// True when the logger prints lines of this level for the tag at runtime
+// (the level set in the YAML, and per tag under logs:).
+inline bool LogLevelEnabled(int level, const char *tag) {
+  return level <= ESPHOME_LOG_LEVEL &&
+         esphome::logger::global_logger != nullptr &&
+         level <= esphome::logger::global_logger->level_for(tag);
+}
+
+// Logging for the protocol code, used instead of ESP_LOGx. The arguments are
+// only evaluated when LogLevelEnabled(), so a frame is not hex dumped for a
+// line that is dropped anyway.
+#define HAIER_LOG(level, tag, format, ...)                                     \
+  do {                                                                         \
+    if (LogLevelEnabled(level, tag))                                           \
+      TaskLog::Printf(level, tag, __LINE__, format, ##__VA_ARGS__);            \
+  } while (0)
+#define HAIER_LOGE(tag, format, ...)                                           \
+  HAIER_LOG(ESPHOME_LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#define HAIER_LOGW(tag, format, ...)                                           \
+  HAIER_LOG(ESPHOME_LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#define HAIER_LOGI(tag, format, ...)                                           \
+  HAIER_LOG(ESPHOME_LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#define HAIER_LOGD(tag, format, ...)                                           \
+  HAIER_LOG(ESPHOME_LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+#define HAIER_LOGV(tag, format, ...)                                           \
+  HAIER_LOG(ESPHOME_LOG_LEVEL_VERBOSE, tag, format, ##__VA_ARGS__)
+
+// Log lines of a task other than the ESPHome loop. Neither the logger nor the
+// API log streaming may be called from there: lines logged by a task that
+// attached a TaskLog are formatted into its queue, and the ESPHome loop
+// prints them with Flush(). Lines logged anywhere else go to the logger
+// directly. Tags must be string literals, only the pointer is queued.
+class TaskLog {
+public:
+  // Task side: lines logged by the calling task go to this queue from now on
+  void Attach();
+  // Free lines in the queue of the calling task, for bursts such as a
+  // history dump. SIZE_MAX when it logs directly.
+  static size_t Room();
+  static void Printf(int level, const char *tag, int line, const char *format,
+                     ...) __attribute__((format(printf, 4, 5)));
+
+  // ESPHome side: prints the queued lines
+  void Flush();
+
+private:
+  struct Record {
+    byte level;
+    int line;
+    const char *tag;
+    char message[kTaskLogLineSize];
+  };
+
+  SpscRing<Record, kTaskLogQueueSize> records_;
+  std::atomic<uint32_t> dropped_{0};
+};
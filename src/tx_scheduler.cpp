@@ -0,0 +1,135 @@
+#include "tx_scheduler.h"
+
+#include "esphome.h"
+
+#include "task_log.h"
+
+using esphome::climate::ClimateCall;
+
+TxScheduler::TxScheduler(Stream &uart, const Status &status,
+                         UnitScheduler &unit_scheduler, LinkStats &stats)
+    : uart_(uart), status_(status), unit_scheduler_(unit_scheduler),
+      stats_(stats), control_(status) {}
+
+void TxScheduler::Queue(const ClimateCall &call) {
+  Queue(ControlRequest::FromCall(call));
+}
+
+void TxScheduler::Queue(const ControlRequest &request) {
+  // While a frame is in flight the status does not show it yet, so further
+  // changes are sent along with the calls of the frame in flight.
+  if (IsIdle())
+    request_ = ControlRequest();
+  request_.Merge(request);
+
+  if (!pending_) {
+    pending_ = true;
+    pending_since_ = millis();
+    refresh_polled_ = false;
+  }
+}
+
+void TxScheduler::Loop() {
+  const uint32_t now = millis();
+
+  if (in_flight_ && now - sent_at_ >= kControlConfirmTimeoutInMilisec) {
+    if (acked_ && now - sent_at_ < kControlAckedTimeoutInMilisec)
+      return;
+    if (acked_) {
+      HAIER_LOGW("EspHaier Tx", "Control acknowledged but never shown");
+      Finish(ControlResult::ControlExpired);
+    } else if (retries_ >= kControlMaxRetries) {
+      HAIER_LOGW("EspHaier Tx", "Control not confirmed after %d retries",
+                 retries_);
+      Finish(ControlResult::ControlExpired);
+    } else if (CanTransmit(now)) {
+      retries_++;
+      HAIER_LOGD("EspHaier Tx", "Control not confirmed, retry %d", retries_);
+      // Resending the current frame also carries any changes queued since
+      Transmit(now);
+    }
+    return;
+  }
+
+  const uint32_t waiting = now - pending_since_;
+  if (pending_ && !in_flight_ && waiting >= kControlCoalesceWindowInMilisec &&
+      (!IsStale(now) || waiting >= kControlRefreshTimeoutInMilisec) &&
+      CanTransmit(now)) {
+    retries_ = 0;
+    Transmit(now);
+  }
+}
+
+void TxScheduler::OnStatus() {
+  if (!in_flight_ || !Control::IsConfirmedBy(in_flight_frame_, status_))
+    return;
+
+  Confirm();
+}
+
+void TxScheduler::OnAck() {
+  // A late answer to an earlier frame or a poll otherwise
+  if (!in_flight_ || acked_ ||
+      millis() - sent_at_ >= kControlConfirmTimeoutInMilisec)
+    return;
+
+  HAIER_LOGD("EspHaier Tx", "Control acknowledged after %u ms",
+             (unsigned)(millis() - sent_at_));
+  acked_ = true;
+}
+
+void TxScheduler::OnRejected() {
+  if (!in_flight_)
+    return;
+
+  HAIER_LOGW("EspHaier Tx", "Control rejected by the AC");
+  Finish(ControlResult::ControlRejected);
+}
+
+void TxScheduler::OnTransmit() {
+  if (pending_)
+    refresh_polled_ = true;
+  last_transmit_ = millis();
+  unit_scheduler_.Acquire(last_transmit_);
+}
+
+bool TxScheduler::CanTransmit(uint32_t now) const {
+  return now - last_transmit_ >= kMinFrameGapInMilisec &&
+         unit_scheduler_.IsFree(now);
+}
+
+bool TxScheduler::NeedsRefresh(uint32_t now) const {
+  return pending_ && !in_flight_ && !refresh_polled_ && IsStale(now);
+}
+
+bool TxScheduler::IsStale(uint32_t now) const {
+  return now - status_.GetStatusTime() > kControlStatusMaxAgeInMilisec;
+}
+
+void TxScheduler::Transmit(uint32_t now) {
+  control_.UpdateFromStatus();
+  control_.Apply(request_.ToCall());
+  control_.ApplyFeatures(request_);
+  control_.Send(uart_);
+  in_flight_frame_ = control_.frame();
+  in_flight_ = true;
+  acked_ = false;
+  pending_ = false;
+  sent_at_ = now;
+  last_transmit_ = now;
+  unit_scheduler_.Acquire(now);
+}
+
+void TxScheduler::Confirm() {
+  const uint32_t latency = millis() - sent_at_;
+
+  HAIER_LOGD("EspHaier Tx", "Control confirmed after %u ms", (unsigned)latency);
+  stats_.control_latency.Record(latency);
+  Finish(ControlResult::ControlConfirmed);
+}
+
+void TxScheduler::Finish(ControlResult result) {
+  in_flight_ = false;
+  if (result_handler_)
+    result_handler_(result);
+}
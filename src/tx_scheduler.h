@@ -0,0 +1,86 @@
+#pragma once
+
+#include <functional>
+
+#include "esphome.h"
+
+#include "constants.h"
+#include "control.h"
+#include "link_stats.h"
+#include "status.h"
+#include "unit_scheduler.h"
+
+// What became of a control frame
+enum ControlResult : byte {
+  // Confirmed by a status
+  ControlConfirmed,
+  ControlRejected,
+  // Still not confirmed after kControlMaxRetries
+  ControlExpired,
+};
+
+// Queues control calls toward the AC. Calls arriving within the coalescing
+// window are merged into a single control frame, frames are spaced by at
+// least kMinFrameGapInMilisec, and a sent frame stays in flight until a
+// status confirms it, or is resent after kControlConfirmTimeoutInMilisec.
+// An acknowledgement (0x05) only stops the resends: it does not tell which
+// frame it answers, so it is trusted within the confirm timeout of the last
+// send and the frame still waits for the status showing it.
+// Transmissions also take a slot in the UnitScheduler shared with the other
+// units of the board.
+//
+// The frame is built when it is sent: only the fields set by the queued
+// calls are applied, on top of the latest status, so changes made meanwhile
+// with the IR remote or the Haier app are kept. When that status is older
+// than kControlStatusMaxAgeInMilisec, NeedsRefresh() asks for a poll first.
+class TxScheduler {
+public:
+  using ResultHandler = std::function<void(ControlResult result)>;
+
+  TxScheduler(Stream &uart, const Status &status,
+              UnitScheduler &unit_scheduler, LinkStats &stats);
+
+  // Called once per control frame, after its last retry
+  void set_result_handler(ResultHandler handler) { result_handler_ = handler; }
+
+  void Queue(const esphome::climate::ClimateCall &call);
+  void Queue(const ControlRequest &request);
+  void Loop();
+  // To be called for every valid status frame
+  void OnStatus();
+  // To be called when the AC acknowledges (0x05) or rejects (0x03) a command
+  void OnAck();
+  void OnRejected();
+  // To be called for frames sent outside of the scheduler (polls)
+  void OnTransmit();
+
+  bool IsIdle() const { return !pending_ && !in_flight_; }
+  bool CanTransmit(uint32_t now) const;
+  // True when a poll should be sent before the pending frame
+  bool NeedsRefresh(uint32_t now) const;
+
+private:
+  bool IsStale(uint32_t now) const;
+  void Transmit(uint32_t now);
+  void Confirm();
+  void Finish(ControlResult result);
+
+  Stream &uart_;
+  const Status &status_;
+  UnitScheduler &unit_scheduler_;
+  LinkStats &stats_;
+  ResultHandler result_handler_;
+  Control control_;
+  // Every call since the scheduler was last idle
+  ControlRequest request_;
+  ControlMessagType in_flight_frame_ = GetControlMessage();
+
+  bool pending_ = false;
+  bool in_flight_ = false;
+  uint32_t pending_since_ = 0;
+  bool refresh_polled_ = false;
+  uint32_t sent_at_ = 0;
+  bool acked_ = false;
+  uint32_t last_transmit_ = 0;
+  uint8_t retries_ = 0;
+};
@@ -0,0 +1,15 @@
+#include "unit_scheduler.h"
+
+UnitScheduler &UnitScheduler::shared() {
+  static UnitScheduler scheduler;
+  return scheduler;
+}
+
+bool UnitScheduler::IsFree(uint32_t now) const {
+  return !acquired_ || now - last_acquired_ >= kUnitStaggerInMilisec;
+}
+
+void UnitScheduler::Acquire(uint32_t now) {
+  acquired_ = true;
+  last_acquired_ = now;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>
+
+#include "esphome.h"
+
+#include "constants.h"
+
+// Shared by all the units driven from one board: each unit has its own UART,
+// but transmissions (polls and control frames) are spaced by
+// kUnitStaggerInMilisec across units so they never all wake up at once.
+// On ESP32 every unit runs on its own protocol task, hence the atomics; two
+// units acquiring at the same moment only lose the stagger once.
+class UnitScheduler {
+public:
+  // Instance shared by every Haier component on the board
+  static UnitScheduler &shared();
+
+  bool IsFree(uint32_t now) const;
+  void Acquire(uint32_t now);
+
+private:
+  std::atomic<bool> acquired_{false};
+  std::atomic<uint32_t> last_acquired_{0};
+};
@@ -2,18 +2,28 @@
 
 #include "esphome.h"
 
-unsigned crc16(unsigned crc, unsigned char *buf, size_t len) {
-  constexpr auto poly = 0xa001;
-  while (len--) {
-    crc ^= *buf++;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
-    crc = crc & 1 ? (crc >> 1) ^ poly : crc >> 1;
+HexDump::HexDump(const byte *data, size_t size) {
+  static constexpr char kDigits[] = "0123456789ABCDEF";
+  const size_t max_size = (sizeof(buffer_) - 1) / 3;
+  char *out = buffer_;
+
+  for (size_t i = 0; i < size && i < max_size; i++) {
+    *out++ = ' ';
+    *out++ = kDigits[data[i] >> 4];
+    *out++ = kDigits[data[i] & 0x0F];
   }
-  return crc;
+  *out = '\0';
+}
+
+void writeFrame(Stream &uart, const byte *data, size_t size) {
+  encodeFrame(data, size, [&uart](const byte *chunk, size_t chunk_size) {
+    uart.write(chunk, chunk_size);
+  });
+}
+
+FrameChecksum computeChecksum(const byte *buf, size_t len) {
+  FrameChecksum checksum;
+  while (len--)
+    checksum.Update(*buf++);
+  return checksum;
 }
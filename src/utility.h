@@ -1,78 +1,104 @@
 #pragma once
 
+#include <array>
+
 #include "esphome.h"
 
+#include "constants.h"
+#include "task_log.h"
+
 template <typename Message> byte crc_offset(const Message &message) {
   return message[2] + 2u;
 }
 
-template <typename Message> byte getChecksum(const Message &message) {
-  byte position = crc_offset(message);
-  byte crc = 0;
+constexpr word kCrc16Polynomial = 0xA001;
 
-  if (message.size() < (position)) {
-    ESP_LOGE("Control", "frame format error (size = %d vs length = %d)",
-             message.size(), message[2]);
-    return 0;
+constexpr std::array<word, 256> MakeCrc16Table() {
+  std::array<word, 256> table = {};
+  for (unsigned i = 0; i < table.size(); i++) {
+    word crc = i;
+    for (int bit = 0; bit < 8; bit++)
+      crc = crc & 1 ? (crc >> 1) ^ kCrc16Polynomial : crc >> 1;
+    table[i] = crc;
   }
-
-  for (int i = 2; i < position; i++)
-    crc += message[i];
-
-  return crc;
+  return table;
 }
 
-unsigned crc16(unsigned crc, unsigned char *buf, size_t len);
+inline constexpr std::array<word, 256> kCrc16Table = MakeCrc16Table();
 
-template <typename Message> String getHex(const Message &message) {
-
-  String raw;
-
-  for (int i = 0; i < message.size(); i++) {
-    raw += " " + String(message[i]);
+// Additive checksum and CRC16 of a frame, both updated from the same byte so
+// that a frame is only walked once.
+struct FrameChecksum {
+  void Update(byte value) {
+    sum += value;
+    crc16 = (crc16 >> 8) ^ kCrc16Table[(crc16 ^ value) & 0xFF];
   }
-  raw.toUpperCase();
 
-  return raw;
-}
-
-// For some reason in captured data when crc16 has FF computed in one of bytes
-// there is a 55 after it, e.g -> FF 55 29. As a "temporary" workaround just
-// hardcore this case. This is ugly hack, but I don't have any idea what is this
-// number.
-template <typename Message>
-bool hackCrc16(Message& message, byte crc16Offset) {
-  if (message[crc16Offset + 1] == 0xff) {
-      message[crc16Offset + 3] = message[crc16Offset + 2];
-      message[crc16Offset + 2] = 0x55;
-      return true;
-    }
-  if (message[crc16Offset + 2] == 0xff) {
-    message[crc16Offset + 2] = message[crc16Offset + 2];
-    message[crc16Offset + 3] = 0x55;
-    return true;
+  byte sum = 0;
+  word crc16 = 0;
+};
+
+FrameChecksum computeChecksum(const byte *buf, size_t len);
+
+// Hex dump of a frame formatted into a stack buffer, so logging a frame does
+// not allocate. Use it in the HAIER_LOGx arguments, which are only evaluated
+// when the line is printed.
+class HexDump {
+public:
+  HexDump(const byte *data, size_t size);
+
+  template <typename Message>
+  explicit HexDump(const Message &message)
+      : HexDump(message.data(), message.size()) {}
+
+  const char *c_str() const { return buffer_; }
+
+private:
+  char buffer_[kMaxFrameSize * 3 + 1];
+};
+
+// After the FF FF header, every 0xFF byte of a frame is followed by 0x55 on
+// the wire so that it cannot be mistaken for a header (e.g. a CRC16 of FF29
+// is sent as FF 55 29). The escape byte is not counted in the length byte.
+// Output is called with consecutive chunks of the encoded frame, straight
+// from the frame buffer.
+template <typename Output>
+void encodeFrame(const byte *data, size_t size, Output output) {
+  static const byte kEscape = kFrameEscape;
+  size_t start = 0;
+
+  for (size_t i = 2; i < size; i++) {
+    if (data[i] != kFrameHeader)
+      continue;
+    output(data + start, i + 1 - start);
+    output(&kEscape, 1);
+    start = i + 1;
   }
-  return false;
+  output(data + start, size - start);
 }
 
-template <typename Message> void sendData(Message &message) {
+void writeFrame(Stream &uart, const byte *data, size_t size);
+
+template <typename Message> void sendData(Stream &uart, Message &message) {
   byte offset = crc_offset(message);
-  byte crc = getChecksum(message);
-  word crc_16 = crc16(0, &(message[2]), offset - 2);
+  if (message.size() < offset + 1u + kCrc16Size) {
+    HAIER_LOGE("EspHaier Utility",
+               "frame format error (size = %d vs length = %d)",
+               (int)message.size(), message[2]);
+    return;
+  }
+
+  const FrameChecksum checksum = computeChecksum(&(message[2]), offset - 2);
+  byte crc = checksum.sum;
+  word crc_16 = checksum.crc16;
 
   // Updates the crc
   message[offset] = crc;
   message[offset + 1] = (crc_16 >> 8) & 0xFF;
   message[offset + 2] = crc_16 & 0xFF;
 
-  String hackInformation = "";
-  if (hackCrc16(message, offset)) {
-    hackInformation = ", but crc16 has been by adding 0x55 after 0xFF";
-  }
-
-  Serial.write(message.data(), message.size());
+  writeFrame(uart, message.data(), offset + 1u + kCrc16Size);
 
-  auto raw = getHex(message);
-  ESP_LOGD("EspHaier Utility", "Message sent: %s  - CRC: %X - CRC16: %X%s",
-           raw.c_str(), crc, crc_16, hackInformation.c_str());
+  HAIER_LOGD("EspHaier Utility", "Message sent: %s  - CRC: %X - CRC16: %X",
+             HexDump(message).c_str(), crc, crc_16);
 }